@@ -1,19 +1,78 @@
 #include "big_integer.h"
+#include "limb_kernels.h"
+#include "limb_mul.h"
+#include "limb_div.h"
+#include "limb_gcd.h"
+#include "limb_prime.h"
+#include "limb_scratch.h"
+#include "thread_pool.h"
+#include "primes.h"
 
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
 #include <stdexcept>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <algorithm>
+#include <limits>
+#include <cmath>
 #define u32 uint32_t
 
 static const big_integer ZERO = 0;
 
-big_integer::big_integer() : positive(true) {
+// |x|, если x занимает не больше двух лимбов: тогда операторы считают
+// в 64/128-битной арифметике и не трогают циклы по лимбам
+static bool abs_u64(big_integer::cont const &d, uint64_t &v) {
+    if (d.size() > 2) {
+        return false;
+    }
+    v = d[0];
+    if (d.size() == 2) {
+        v |= static_cast<uint64_t>(d[1]) << 32;
+    }
+    return true;
+}
+
+// r = |x| * |y|, r длины x.size() + y.size() не пересекается с x и y
+static void mul_abs(u32 *r, big_integer::cont const &x, big_integer::cont const &y, size_t max_threads) {
+    size_t n = x.size();
+    size_t m = y.size();
+    if ((&x == &y || x.shares(y)) && max_threads <= 1) {
+        sqr_limbs(r, x.span(), n);
+    } else if (n >= m) {
+        mul_limbs_parallel(r, x.span(), n, y.span(), m, max_threads);
+    } else {
+        mul_limbs_parallel(r, y.span(), m, x.span(), n, max_threads);
+    }
+}
+
+// дополнительный код в v превращает в модуль на месте; true, если число отрицательно
+static bool from_twos(big_integer::cont &v) {
+    if (!(v.span()[v.size() - 1] >> 31)) {
+        return false;
+    }
+    u32 *d = v.mutable_span();
+    bool carry = true;
+    for (size_t i = 0; i < v.size(); i++) {
+        d[i] = ~d[i] + carry;
+        carry = carry && d[i] == 0;
+    }
+    return true;
+}
+
+big_integer::big_integer() {
     data_.push_back(0);
 }
 
-big_integer::big_integer(big_integer const &other) = default;
+big_integer::big_integer(big_integer const &other) : data_(other.data_) {
+    data_.positive = other.data_.positive;
+}
+
+big_integer::big_integer(big_integer &&other) noexcept : big_integer() {
+    swap(other);
+}
 
 big_integer::big_integer(int a) {
     if (a == std::numeric_limits<int>::min()) {
@@ -21,30 +80,151 @@ big_integer::big_integer(int a) {
     } else {
         data_.push_back(abs(a));
     }
-    positive = a >= 0;
+    data_.positive = a >= 0;
+}
+
+big_integer::big_integer(unsigned a) : big_integer(static_cast<uint128_t>(a)) {}
+
+big_integer::big_integer(long a) : big_integer(static_cast<int128_t>(a)) {}
+
+big_integer::big_integer(unsigned long a) : big_integer(static_cast<uint128_t>(a)) {}
+
+big_integer::big_integer(long long a) : big_integer(static_cast<int128_t>(a)) {}
+
+big_integer::big_integer(unsigned long long a) : big_integer(static_cast<uint128_t>(a)) {}
+
+big_integer::big_integer(int128_t a) : big_integer(a < 0 ? 0 - static_cast<uint128_t>(a) : static_cast<uint128_t>(a)) {
+    data_.positive = a >= 0;
+}
+
+big_integer::big_integer(uint128_t a) {
+    data_.push_back(static_cast<u32>(a));
+    for (a >>= BASE; a != 0; a >>= BASE) {
+        data_.push_back(static_cast<u32>(a));
+    }
+}
+
+big_integer::big_integer(double a) : big_integer() {
+    if (!std::isfinite(a)) {
+        throw std::domain_error("not a finite number");
+    }
+    // |a| = m 2^e, m — целое из 53 бит
+    int e;
+    double f = std::frexp(std::fabs(a), &e);
+    if (e <= 0) {
+        return;
+    }
+    uint64_t m = static_cast<uint64_t>(std::ldexp(f, 53));
+    if (e <= 53) {
+        *this = big_integer(m >> (53 - e));
+    } else {
+        *this = big_integer(m) << (e - 53);
+    }
+    data_.positive = a >= 0 || is_zero();
 }
 
 big_integer::big_integer(std::string const &str) : big_integer() {
-    big_integer base = 1;
-    positive = true;
-    for (u32 i = str.size(); i != (u32)(str[0] == '-'); i--) {
-        *this += base * (str[i - 1] - '0');
-        base *= 10;
+    size_t start = str[0] == '-' ? 1 : 0;
+    std::vector<u32> v(1, 0);
+    size_t first = start + (str.size() - start) % 9;
+    if (first == start) {
+        first += 9;
     }
-    if (str[0] == '-' && *this != ZERO) {
-        positive = false;
+    // по 9 цифр: v = v * 10^9 + chunk
+    for (size_t i = start, j = first; i < str.size(); i = j, j += 9) {
+        u32 chunk = 0;
+        u32 scale = 1;
+        for (size_t k = i; k < j; k++) {
+            chunk = chunk * 10 + (str[k] - '0');
+            scale *= 10;
+        }
+        u32 carry = kernels().mul_1(v.data(), v.data(), v.size(), scale);
+        for (size_t k = 0; chunk && k < v.size(); k++) {
+            v[k] += chunk;
+            chunk = v[k] < chunk;
+        }
+        if (carry || chunk) {
+            v.push_back(carry + chunk);
+        }
     }
+    data_.resize(v.size());
+    std::copy(v.begin(), v.end(), data_.mutable_span());
+    to_fit(data_);
+    data_.positive = start == 0 || *this == ZERO;
 }
 
 big_integer::~big_integer() = default;
 
-big_integer &big_integer::operator=(big_integer const &other) = default;
+big_integer &big_integer::operator=(big_integer const &other) {
+    data_ = other.data_;
+    data_.positive = other.data_.positive;
+    return *this;
+}
+
+big_integer &big_integer::operator=(big_integer &&other) noexcept {
+    swap(other);
+    return *this;
+}
+
+void big_integer::swap(big_integer &other) noexcept {
+    data_.swap(other.data_);
+    bool p = data_.positive;
+    data_.positive = other.data_.positive;
+    other.data_.positive = p;
+}
+
+void swap(big_integer &a, big_integer &b) noexcept {
+    a.swap(b);
+}
+
+size_t big_integer::capacity() const {
+    return data_.capacity();
+}
+
+void big_integer::reserve(size_t limbs) {
+    data_.reserve(limbs);
+}
+
+void big_integer::shrink_to_fit() {
+    data_.shrink_to_fit();
+}
+
+void big_integer::negate() {
+    if (!is_zero()) {
+        data_.positive ^= true;
+    }
+}
+
+// *this = (positive ? v : -v), до четырёх лимбов
+void big_integer::set_small(uint128_t v, bool sign) {
+    size_t n = 1;
+    while (n < 4 && v >> (BASE * n) != 0) {
+        n++;
+    }
+    data_.resize(n);
+    u32 *d = data_.mutable_span();
+    for (size_t i = 0; i < n; i++) {
+        d[i] = static_cast<u32>(v >> (BASE * i));
+    }
+    data_.positive = sign || v == 0;
+}
 
 big_integer &big_integer::operator+=(big_integer const &rhs) {
-    if (positive && !rhs.positive) {
+    uint64_t x, y;
+    if (abs_u64(data_, x) && abs_u64(rhs.data_, y)) {
+        int128_t r = (data_.positive ? static_cast<int128_t>(x) : -static_cast<int128_t>(x)) +
+                     (rhs.data_.positive ? static_cast<int128_t>(y) : -static_cast<int128_t>(y));
+        set_small(r < 0 ? 0 - static_cast<uint128_t>(r) : static_cast<uint128_t>(r), r >= 0);
+        return *this;
+    }
+    if (data_.positive && !rhs.data_.positive) {
         *this -= -rhs;
-    } else if (!positive && rhs.positive) {
-        *this = rhs - (-*this);
+    } else if (!data_.positive && rhs.data_.positive) {
+        // rhs - |*this| прямо в своём буфере
+        data_.positive = true;
+        bool tp = *this <= rhs;
+        sub_abs(rhs);
+        data_.positive = tp;
     } else {
         sum_abs(rhs);
     }
@@ -52,56 +232,78 @@ big_integer &big_integer::operator+=(big_integer const &rhs) {
 }
 
 big_integer &big_integer::operator-=(big_integer const &rhs) {
-    if (positive && !rhs.positive) {
+    uint64_t x, y;
+    if (abs_u64(data_, x) && abs_u64(rhs.data_, y)) {
+        int128_t r = (data_.positive ? static_cast<int128_t>(x) : -static_cast<int128_t>(x)) -
+                     (rhs.data_.positive ? static_cast<int128_t>(y) : -static_cast<int128_t>(y));
+        set_small(r < 0 ? 0 - static_cast<uint128_t>(r) : static_cast<uint128_t>(r), r >= 0);
+        return *this;
+    }
+    if (data_.positive && !rhs.data_.positive) {
         sum_abs(rhs);
-    } else if (!positive && rhs.positive) {
+    } else if (!data_.positive && rhs.data_.positive) {
         sum_abs(rhs);
-    } else if (positive && rhs.positive) {
+    } else if (data_.positive && rhs.data_.positive) {
         bool tp = *this >= rhs;
         sub_abs(rhs);
-        positive = tp;
-    } else if (!positive && !rhs.positive) {
+        data_.positive = tp;
+    } else if (!data_.positive && !rhs.data_.positive) {
         bool tp = *this >= rhs;
         sub_abs(rhs);
-        positive = tp;
+        data_.positive = tp;
     }
     return *this;
 }
 
 big_integer &big_integer::operator*=(big_integer const &rhs) {
-    big_integer result;
-    result.data_.resize(data_.size() + rhs.data_.size());
-    for (size_t i = 0; i < data_.size(); i++) {
-        u32 over = 0;
-        for (size_t j = 0; j < rhs.data_.size(); j++) {
-            auto p = split64(static_cast<uint64_t>(data_[i]) * rhs.data_[j] + result.data_[i + j] + over);
-            result.data_[i + j] = p.first;
-            over = p.second;
-        }
-        if (over) {
-            result.data_[i + rhs.data_.size()] = over;
-        }
+    uint64_t x, y;
+    if (abs_u64(data_, x) && abs_u64(rhs.data_, y)) {
+        set_small(static_cast<uint128_t>(x) * y, data_.positive == rhs.data_.positive);
+        return *this;
     }
-    to_fit(result.data_);
-    result.positive = positive == rhs.positive;
-    *this = result;
+    // произведение на стеке временных и обратно в свой буфер: если он
+    // единоличный и вмещает результат, памяти не выделяется
+    size_t n = data_.size() + rhs.data_.size();
+    scratch_mark mark;
+    u32 *t = mark.alloc(n);
+    mul_abs(t, data_, rhs.data_, mul_threads());
+    bool sign = data_.positive == rhs.data_.positive;
+    if (n > data_.capacity() || !data_.unique()) {
+        // новый буфер не меньше прежней вместимости, старые лимбы в него не копируются
+        cont owned;
+        owned.reserve(std::max(n, data_.capacity()));
+        data_ = std::move(owned);
+    }
+    data_.resize(n);
+    std::copy(t, t + n, data_.mutable_span());
+    to_fit(data_);
+    data_.positive = sign || is_zero();
     return *this;
-
 }
 
 big_integer &big_integer::operator/=(big_integer const &rhs) {
-    bool sign = positive == rhs.positive;
-    positive = true;
-    data_ = div(*this, rhs).first.data_;
-    positive = sign;
-    if (*this == ZERO) {
-        positive = true;
+    uint64_t x, y;
+    if (abs_u64(data_, x) && abs_u64(rhs.data_, y) && y != 0) {
+        set_small(x / y, data_.positive == rhs.data_.positive);
+        return *this;
     }
+    bool sign = data_.positive == rhs.data_.positive;
+    data_.positive = true;
+    data_.assign(div(*this, rhs).first.data_);
+    data_.positive = sign || is_zero();
     return *this;
 }
 
 big_integer &big_integer::operator%=(big_integer const &rhs) {
-    *this -= (*this / rhs) * rhs;
+    uint64_t x, y;
+    if (abs_u64(data_, x) && abs_u64(rhs.data_, y) && y != 0) {
+        set_small(x % y, data_.positive);
+        return *this;
+    }
+    bool sign = data_.positive;
+    data_.positive = true;
+    data_.assign(div(*this, rhs).second.data_);
+    data_.positive = sign || is_zero();
     return *this;
 }
 
@@ -114,12 +316,14 @@ big_integer &big_integer::operator&=(big_integer const &rhs) {
     if (d2.size() < d1.size()) {
         d2.resize(d1.size(), highBit(d2) ? MAX_DIGIT : 0);
     }
+    u32 *r = d1.mutable_span();
+    u32 const *b = d2.span();
     for (size_t i = 0; i < d1.size(); i++) {
-        d1[i] &= d2[i];
+        r[i] &= b[i];
     }
-    bool high = highBit(d1);
-    data_ = addition_to_2(d1, true);
-    positive = !high;
+    bool negative = from_twos(d1);
+    data_.assign(d1);
+    data_.positive = !negative;
     to_fit(data_);
     return *this;
 }
@@ -133,12 +337,14 @@ big_integer &big_integer::operator|=(big_integer const &rhs) {
     if (d2.size() < d1.size()) {
         d2.resize(d1.size(), highBit(d2) ? MAX_DIGIT : 0);
     }
+    u32 *r = d1.mutable_span();
+    u32 const *b = d2.span();
     for (size_t i = 0; i < d1.size(); i++) {
-        d1[i] |= d2[i];
+        r[i] |= b[i];
     }
-    bool high = highBit(d1);
-    data_ = addition_to_2(d1, true);
-    positive = !high;
+    bool negative = from_twos(d1);
+    data_.assign(d1);
+    data_.positive = !negative;
     to_fit(data_);
     return *this;
 }
@@ -152,12 +358,14 @@ big_integer &big_integer::operator^=(big_integer const &rhs) {
     if (d2.size() < d1.size()) {
         d2.resize(d1.size(), highBit(d2) ? MAX_DIGIT : 0);
     }
+    u32 *r = d1.mutable_span();
+    u32 const *b = d2.span();
     for (size_t i = 0; i < d1.size(); i++) {
-        d1[i] ^= d2[i];
+        r[i] ^= b[i];
     }
-    bool high = highBit(d1);
-    data_ = addition_to_2(d1, true);
-    positive = !high;
+    bool negative = from_twos(d1);
+    data_.assign(d1);
+    data_.positive = !negative;
     to_fit(data_);
     return *this;
 }
@@ -165,54 +373,60 @@ big_integer &big_integer::operator^=(big_integer const &rhs) {
 big_integer &big_integer::operator<<=(int rhs) {
     int in = rhs % BASE;
     int out = rhs / BASE;
-    cont res((size_t) (data_.size() + out + 1));
-    for (size_t i = data_.size(); i != 0; i--) {
-        auto p = split64(static_cast<uint64_t>(data_[i - 1]) << in);
-        res[i + out - 1] |= p.first;
-        res[i + out] |= p.second;
+    size_t n = data_.size();
+    // сдвиг на месте, от старших лимбов к младшим
+    data_.resize(n + out + 1);
+    u32 *r = data_.mutable_span();
+    if (in) {
+        r[n + out] = kernels().lshift(r + out, r, n, in);
+    } else {
+        std::copy_backward(r, r + n, r + n + out);
     }
-    data_ = res;
+    std::fill(r, r + out, 0);
     to_fit(data_);
     return *this;
 }
 
 big_integer &big_integer::operator>>=(int rhs) {
     int in = rhs % BASE;
-    int out = rhs / BASE;
-    auto d = addition_to_2(data_);
-    cont res(d.size());
-    for (int i = 0; i != (int) d.size(); i++) {
-        auto p = split64(static_cast<uint64_t>(d[i]) << (BASE - in));
-        if (i - out >= 0) {
-            res[i - out] |= p.second;
+    size_t out = rhs / BASE;
+    if (data_.positive) {
+        size_t n = data_.size();
+        if (out >= n) {
+            set_small(0, true);
+            return *this;
         }
-        if (i - out - 1 >= 0) {
-            res[i - out - 1] |= p.first;
+        u32 *r = data_.mutable_span();
+        if (in) {
+            kernels().rshift(r, r + out, n - out, in);
+        } else {
+            std::copy(r + out, r + n, r);
         }
+        data_.truncate(n - out);
+        to_fit(data_);
+        return *this;
     }
-    if (!positive) {
-        size_t i = res.size();
-        for (; i != 0; i--) {
-            if (res[i - 1] == 0) {
-                res[i - 1] = MAX_DIGIT;
-            } else {
-                break;
-            }
-        }
-        if (i) {
-            for (u32 j = 1 << 31; j != 0; j >>= 1) {
-                if ((res[i - 1] & j) != 0) {
-                    break;
-                }
-                res[i - 1] |= j;
-            }
+    // дополнительный код сдвигается на месте; результат не меньше -1
+    auto d = addition_to_2(data_);
+    size_t n = d.size();
+    u32 *r = d.mutable_span();
+    if (out < n) {
+        if (in) {
+            kernels().rshift(r, r + out, n - out, in);
+        } else {
+            std::copy(r + out, r + n, r);
         }
     }
-    data_ = addition_to_2(res, true);
-    to_fit(data_);
-    if (*this == ZERO) {
-        positive = true;
+    // арифметический сдвиг: освободившиеся старшие биты заполняются единицами
+    for (size_t i = n - std::min(out, n); i < n; i++) {
+        r[i] = MAX_DIGIT;
+    }
+    if (out < n && in) {
+        r[n - out - 1] |= ~(MAX_DIGIT >> in);
     }
+    from_twos(d);
+    data_.assign(d);
+    to_fit(data_);
     return *this;
 }
 
@@ -222,9 +436,7 @@ big_integer big_integer::operator+() const {
 
 big_integer big_integer::operator-() const {
     big_integer r(*this);
-    if (r != 0) {
-        r.positive ^= true;
-    }
+    r.negate();
     return r;
 }
 
@@ -253,47 +465,100 @@ big_integer big_integer::operator--(int) {
 }
 
 big_integer operator+(big_integer a, big_integer const &b) {
-    return a += b;
+    a += b;
+    return a;
 }
 
 big_integer operator-(big_integer a, big_integer const &b) {
-    return a -= b;
+    a -= b;
+    return a;
+}
+
+big_integer operator+(big_integer const &a, big_integer &&b) {
+    b += a;
+    return std::move(b);
+}
+
+// true, если сумму или разность двух временных выгоднее писать в буфер b:
+// сначала тот, что единоличный и вмещает результат без выделения памяти,
+// а если таких нет или оба — более длинный
+static bool reuse_second(big_integer::cont const &a, big_integer::cont const &b) {
+    size_t n = std::max(a.size(), b.size()) + 1;
+    bool fits_a = a.unique() && a.capacity() >= n;
+    bool fits_b = b.unique() && b.capacity() >= n;
+    if (fits_a != fits_b) {
+        return fits_b;
+    }
+    return a.size() < b.size();
+}
+
+big_integer operator+(big_integer &&a, big_integer &&b) {
+    if (reuse_second(a.data_, b.data_)) {
+        b += a;
+        return std::move(b);
+    }
+    a += b;
+    return std::move(a);
+}
+
+big_integer operator-(big_integer const &a, big_integer &&b) {
+    b -= a;
+    b.negate();
+    return std::move(b);
+}
+
+big_integer operator-(big_integer &&a, big_integer &&b) {
+    if (reuse_second(a.data_, b.data_)) {
+        b -= a;
+        b.negate();
+        return std::move(b);
+    }
+    a -= b;
+    return std::move(a);
 }
 
 big_integer operator*(big_integer a, big_integer const &b) {
-    return a *= b;
+    a *= b;
+    return a;
 }
 
 big_integer operator/(big_integer a, big_integer const &b) {
-    return a /= b;
+    a /= b;
+    return a;
 }
 
 big_integer operator%(big_integer a, big_integer const &b) {
-    return a %= b;
+    a %= b;
+    return a;
 }
 
 big_integer operator&(big_integer a, big_integer const &b) {
-    return a &= b;
+    a &= b;
+    return a;
 }
 
 big_integer operator|(big_integer a, big_integer const &b) {
-    return a |= b;
+    a |= b;
+    return a;
 }
 
 big_integer operator^(big_integer a, big_integer const &b) {
-    return a ^= b;
+    a ^= b;
+    return a;
 }
 
 big_integer operator<<(big_integer a, int b) {
-    return a <<= b;
+    a <<= b;
+    return a;
 }
 
 big_integer operator>>(big_integer a, int b) {
-    return a >>= b;
+    a >>= b;
+    return a;
 }
 
 bool operator==(big_integer const &a, big_integer const &b) {
-    return a.data_ == b.data_ && a.positive == b.positive;
+    return a.data_ == b.data_ && a.data_.positive == b.data_.positive;
 }
 
 bool operator!=(big_integer const &a, big_integer const &b) {
@@ -301,15 +566,15 @@ bool operator!=(big_integer const &a, big_integer const &b) {
 }
 
 bool operator<(big_integer const &a, big_integer const &b) {
-    if (a.positive != b.positive) {
-        return !a.positive && b.positive;
+    if (a.data_.positive != b.data_.positive) {
+        return !a.data_.positive && b.data_.positive;
     }
     if (a.data_.size() != b.data_.size()) {
-        return (a.data_.size() < b.data_.size()) ^ !a.positive;
+        return (a.data_.size() < b.data_.size()) ^ !a.data_.positive;
     }
     for (size_t i = a.data_.size(); i > 0; --i) {
         if (a.data_[i - 1] != b.data_[i - 1]) {
-            return (a.data_[i - 1] < b.data_[i - 1]) ^ !a.positive;
+            return (a.data_[i - 1] < b.data_[i - 1]) ^ !a.data_.positive;
         }
     }
     return false;
@@ -327,80 +592,972 @@ bool operator>=(big_integer const &a, big_integer const &b) {
     return !(a < b);
 }
 
+int64_t to_int64(big_integer const &a) {
+    uint64_t v;
+    uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + (a.data_.positive ? 0 : 1);
+    if (!abs_u64(a.data_, v) || v > limit) {
+        throw std::out_of_range("does not fit in int64_t");
+    }
+    return a.data_.positive ? static_cast<int64_t>(v) : static_cast<int64_t>(0 - v);
+}
+
+uint64_t to_uint64(big_integer const &a) {
+    uint64_t v;
+    if (!abs_u64(a.data_, v) || (!a.data_.positive && v != 0)) {
+        throw std::out_of_range("does not fit in uint64_t");
+    }
+    return v;
+}
+
+double to_double(big_integer const &a) {
+    big_integer::cont const &d = a.data_;
+    size_t n = d.size();
+    uint64_t v;
+    double r;
+    if (abs_u64(d, v)) {
+        r = static_cast<double>(v);
+    } else {
+        // старшие 64 бита, выровненные по старшему биту; младший бит — «липкий»:
+        // он есть, если ниже осталось хоть что-то ненулевое. Округление
+        // uint64 -> double тогда совпадает с округлением всего числа
+        unsigned s = static_cast<unsigned>(__builtin_clz(d[n - 1]));
+        uint64_t top = static_cast<uint64_t>(d[n - 1]) << 32 | d[n - 2];
+        u32 next = d[n - 3];
+        bool sticky = (s == 0 ? next : next << s) != 0;
+        for (size_t i = 0; !sticky && i + 3 < n; i++) {
+            sticky = d[i] != 0;
+        }
+        if (s != 0) {
+            top = top << s | next >> (32 - s);
+        }
+        r = std::ldexp(static_cast<double>(top | (sticky ? 1 : 0)), static_cast<int>(32 * (n - 2) - s));
+    }
+    return a.data_.positive ? r : -r;
+}
+
 std::string to_string(big_integer const &a) {
-    string res = "";
-    big_integer temp = a;
-    bool neg = false;
-    if (!temp.positive) {
-        neg = true;
-        temp.positive = true;
-    }
-    const u32 billion = 1000000000;
-    while (temp != 0) {
-        string ad = to_string((temp % billion).data_[0]);
-        std::reverse(ad.begin(), ad.end());
-        res += ad;
-        res.insert(res.end(), 9 - ad.size(), '0');
-        temp /= billion;
-    }
-    for (; res.size() > 1 && res.back() == '0'; res.pop_back());
-    if (neg && !res.empty()) {
-        res += "-";
-    }
-    std::reverse(res.begin(), res.end());
-    if (res.empty()) {
+    big_integer::cont const &d = a.data_;
+    size_t n = d.size();
+    std::vector<u32> t(d.span(), d.span() + n);
+    std::vector<u32> chunks;
+    while (n != 0) {
+        chunks.push_back(divrem_1_billion(t.data(), t.data(), n));
+        while (n != 0 && t[n - 1] == 0) {
+            n--;
+        }
+    }
+    if (chunks.empty()) {
         return "0";
     }
+    string res = a.data_.positive ? "" : "-";
+    res += to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- != 0;) {
+        string part = to_string(chunks[i]);
+        res.append(9 - part.size(), '0');
+        res += part;
+    }
     return res;
 }
+big_integer big_integer::multiply(big_integer const &a, big_integer const &b, size_t max_threads) {
+    cont const &x = a.data_;
+    cont const &y = b.data_;
+    size_t n = x.size();
+    size_t m = y.size();
+    big_integer result;
+    result.data_.resize(n + m);
+    mul_abs(result.data_.mutable_span(), x, y, max_threads);
+    to_fit(result.data_);
+    result.data_.positive = a.data_.positive == b.data_.positive || result.is_zero();
+    return result;
+}
+
+big_integer parallel_mul(big_integer const &a, big_integer const &b, size_t max_threads) {
+    return big_integer::multiply(a, b, max_threads);
+}
+
+big_integer divexact(big_integer const &a, big_integer const &b) {
+    if (b.is_zero()) {
+        throw std::domain_error("division by zero");
+    }
+    big_integer x = a;
+    big_integer y = b;
+    x.data_.positive = true;
+    y.data_.positive = true;
+    // общая степень двойки убирается сдвигом, чтобы младший лимб делителя стал нечётным
+    big_integer::cont const &yd = y.data_;
+    int shift = 0;
+    while (yd[shift / big_integer::BASE] == 0) {
+        shift += big_integer::BASE;
+    }
+    shift += __builtin_ctz(yd[shift / big_integer::BASE]);
+    if (shift) {
+        x >>= shift;
+        y >>= shift;
+    }
+    big_integer::cont const &u = x.data_;
+    big_integer::cont const &d = y.data_;
+    size_t n = u.size();
+    size_t m = d.size();
+    if (n < m) {
+        return 0;
+    }
+    big_integer q;
+    q.data_.resize(n - m + 1);
+    divexact_limbs(q.data_.mutable_span(), u.span(), n, d.span(), m);
+    big_integer::to_fit(q.data_);
+    q.data_.positive = a.data_.positive == b.data_.positive || q.is_zero();
+    return q;
+}
+
+// матрицы 2x2 хранятся построчно: m[0] m[1] / m[2] m[3]
+static void set_identity(big_integer *m) {
+    m[0] = 1;
+    m[1] = 0;
+    m[2] = 0;
+    m[3] = 1;
+}
+
+// m = l * m
+static void mul_left(big_integer const *l, big_integer *m) {
+    big_integer t0 = l[0] * m[0] + l[1] * m[2];
+    big_integer t1 = l[0] * m[1] + l[1] * m[3];
+    big_integer t2 = l[2] * m[0] + l[3] * m[2];
+    m[3] = l[2] * m[1] + l[3] * m[3];
+    m[0] = t0;
+    m[1] = t1;
+    m[2] = t2;
+}
+
+// m = (0 1; 1 -q) * m — один шаг Евклида
+static void mul_left_step(big_integer const &q, big_integer *m) {
+    big_integer t0 = m[0] - q * m[2];
+    big_integer t1 = m[1] - q * m[3];
+    std::swap(m[0], m[2]);
+    std::swap(m[1], m[3]);
+    m[2] = t0;
+    m[3] = t1;
+}
+
+// (a, b) = r (a, b); матрица, найденная по старшей половине, может ошибиться
+// в последних шагах, поэтому знаки и порядок чинятся, а r исправляется так,
+// чтобы оставаться унимодулярной и описывать то, что получилось на самом деле
+static void apply_matrix(big_integer *r, big_integer &a, big_integer &b) {
+    big_integer x = r[0] * a + r[1] * b;
+    big_integer y = r[2] * a + r[3] * b;
+    if (x < 0) {
+        x = -x;
+        r[0] = -r[0];
+        r[1] = -r[1];
+    }
+    if (y < 0) {
+        y = -y;
+        r[2] = -r[2];
+        r[3] = -r[3];
+    }
+    if (x < y) {
+        std::swap(x, y);
+        std::swap(r[0], r[2]);
+        std::swap(r[1], r[3]);
+    }
+    a = x;
+    b = y;
+}
+
+// (a, b) = (b, a mod b), возвращает частное
+big_integer big_integer::euclid_step(big_integer &a, big_integer &b) {
+    pair<big_integer, big_integer> qr = div(a, b);
+    a = b;
+    b = qr.second;
+    return qr.first;
+}
+
+// a >= b >= 0, в a не меньше 5 лимбов; l — применённая матрица
+bool big_integer::lehmer_reduce(big_integer &a, big_integer &b, lehmer_matrix &l) {
+    size_t n = a.data_.size();
+    if (!lehmer_step(a.data_.span(), n, b.data_.span(), b.data_.size(), l)) {
+        return false;
+    }
+    if (b.data_.size() < n) {
+        b.data_.resize(n);
+    }
+    u32 *x = a.data_.mutable_span();
+    u32 *y = b.data_.mutable_span();
+    lehmer_apply(x, y, x, y, n, l);
+    to_fit(a.data_);
+    to_fit(b.data_);
+    return true;
+}
+
+// (x, y) = |l| (x, y) для неотрицательных x, y
+void big_integer::lehmer_combine(big_integer &x, big_integer &y, lehmer_matrix const &l) {
+    lehmer_matrix p = {std::abs(l.m00), std::abs(l.m01), std::abs(l.m10), std::abs(l.m11)};
+    size_t n = std::max(x.data_.size(), y.data_.size()) + 2;
+    x.data_.resize(n);
+    y.data_.resize(n);
+    u32 *r0 = x.data_.mutable_span();
+    u32 *r1 = y.data_.mutable_span();
+    lehmer_apply(r0, r1, r0, r1, n, p);
+    to_fit(x.data_);
+    to_fit(y.data_);
+}
+
+void big_integer::to_matrix(lehmer_matrix const &l, big_integer *m) {
+    int64_t const c[4] = {l.m00, l.m01, l.m10, l.m11};
+    for (size_t i = 0; i < 4; i++) {
+        m[i] = big_integer(c[i] < 0 ? -static_cast<uint128_t>(c[i]) : static_cast<uint128_t>(c[i]));
+        m[i].data_.positive = c[i] >= 0 || m[i].is_zero();
+    }
+}
+
+// половинный НОД: a >= b >= 0 длины n сводятся к соседним остаткам, из которых
+// меньший не длиннее n / 2 + 1 лимба; m — матрица перехода. Рекурсия по старшим
+// половинам даёт O(M(n) log n) вместо квадрата
+void big_integer::hgcd(big_integer &a, big_integer &b, big_integer *m) {
+    set_identity(m);
+    size_t n = a.data_.size();
+    size_t h = n / 2 + 1;
+    if (b.data_.size() <= h) {
+        return;
+    }
+    big_integer r[4];
+    if (n >= HGCD_THRESHOLD) {
+        // старшая половина сокращается вдвое, то есть весь размер — на четверть
+        int shift = static_cast<int>(BASE * (n / 2));
+        big_integer x = a >> shift;
+        big_integer y = b >> shift;
+        hgcd(x, y, r);
+        apply_matrix(r, a, b);
+        mul_left(r, m);
+        if (b.data_.size() > h) {
+            mul_left_step(euclid_step(a, b), m);
+        }
+        if (b.data_.size() > h) {
+            // ещё четверть: в рекурсию идут старшие 2 (k - h) лимбов
+            shift = static_cast<int>(BASE * (2 * h - a.data_.size()));
+            x = a >> shift;
+            y = b >> shift;
+            hgcd(x, y, r);
+            apply_matrix(r, a, b);
+            mul_left(r, m);
+        }
+    }
+    // дальше идут только точные шаги Евклида, а у их произведения знаки
+    // чередуются шахматно: |L M| = |L| |M|, поэтому копятся модули и чётность
+    set_identity(r);
+    bool odd = false;
+    bool any = false;
+    while (b.data_.size() > h) {
+        lehmer_matrix l;
+        if (a.data_.size() >= 5 && lehmer_reduce(a, b, l)) {
+            lehmer_combine(r[0], r[2], l);
+            lehmer_combine(r[1], r[3], l);
+            odd ^= l.m11 < 0;
+        } else {
+            big_integer q = euclid_step(a, b);
+            std::swap(r[0], r[2]);
+            std::swap(r[1], r[3]);
+            r[2] += q * r[0];
+            r[3] += q * r[1];
+            odd ^= true;
+        }
+        any = true;
+    }
+    if (any) {
+        r[odd ? 0 : 1] = -r[odd ? 0 : 1];
+        r[odd ? 3 : 2] = -r[odd ? 3 : 2];
+        mul_left(r, m);
+    }
+}
+
+// a >= b >= 0 сводятся к (НОД, 0); u — коэффициенты исходного a в текущих
+// (a, b), если нужны
+void big_integer::gcd_reduce(big_integer &a, big_integer &b, big_integer *u) {
+    while (!b.is_zero()) {
+        size_t n = a.data_.size();
+        if (u == nullptr && n <= 4) {
+            // влезает в 128 бит: остатки, а с 64 бит — бинарный алгоритм
+            cont const &x = a.data_;
+            cont const &y = b.data_;
+            uint128_t p = 0;
+            uint128_t q = 0;
+            for (size_t i = n; i-- != 0;) {
+                p = (p << BASE) | x[i];
+                q = (q << BASE) | (i < y.size() ? y[i] : 0);
+            }
+            while (q != 0 && (p >> 64) != 0) {
+                uint128_t t = p % q;
+                p = q;
+                q = t;
+            }
+            if (q != 0) {
+                p = gcd_u64(static_cast<uint64_t>(p), static_cast<uint64_t>(q));
+            }
+            a = big_integer(p);
+            b = 0;
+            break;
+        }
+        big_integer r[4];
+        if (n < 5 || b.data_.size() + 1 < n) {
+            big_integer q = euclid_step(a, b);
+            if (u) {
+                big_integer t = u[0] - q * u[1];
+                u[0] = u[1];
+                u[1] = t;
+            }
+            continue;
+        }
+        lehmer_matrix l;
+        if (n >= HGCD_THRESHOLD) {
+            hgcd(a, b, r);
+        } else if (lehmer_reduce(a, b, l)) {
+            if (u == nullptr) {
+                continue;
+            }
+            to_matrix(l, r);
+        } else {
+            set_identity(r);
+            mul_left_step(euclid_step(a, b), r);
+        }
+        if (u) {
+            big_integer t = r[0] * u[0] + r[1] * u[1];
+            u[1] = r[2] * u[0] + r[3] * u[1];
+            u[0] = t;
+        }
+    }
+}
+
+big_integer gcd(big_integer const &a, big_integer const &b) {
+    big_integer x = a;
+    big_integer y = b;
+    x.data_.positive = true;
+    y.data_.positive = true;
+    if (x < y) {
+        std::swap(x, y);
+    }
+    big_integer::gcd_reduce(x, y, nullptr);
+    return x;
+}
+
+big_integer extended_gcd(big_integer const &a, big_integer const &b, big_integer &x, big_integer &y) {
+    big_integer p = a;
+    big_integer q = b;
+    p.data_.positive = true;
+    q.data_.positive = true;
+    bool swapped = p < q;
+    if (swapped) {
+        std::swap(p, q);
+    }
+    big_integer g = p;
+    big_integer r = q;
+    big_integer u[2] = {1, 0};
+    big_integer::gcd_reduce(g, r, u);
+    // g = s p + t q; s приводится в (-q / 2g, q / 2g], t находится точным делением
+    big_integer s = u[0];
+    big_integer t = 0;
+    if (q.is_zero()) {
+        s = g.is_zero() ? 0 : 1;
+    } else {
+        big_integer period = divexact(q, g);
+        s %= period;
+        if (2 * s > period) {
+            s -= period;
+        } else if (2 * s <= -period) {
+            s += period;
+        }
+        t = divexact(g - s * p, q);
+    }
+    if (swapped) {
+        std::swap(s, t);
+    }
+    x = a.data_.positive ? s : -s;
+    y = b.data_.positive ? t : -t;
+    return g;
+}
+
+big_integer mod_inverse(big_integer const &a, big_integer const &m) {
+    big_integer x;
+    big_integer y;
+    if (m == 0 || extended_gcd(a, m, x, y) != 1) {
+        throw std::domain_error("not invertible");
+    }
+    big_integer r = x % m;
+    if (r < 0) {
+        r += m < 0 ? -m : m;
+    }
+    return r;
+}
+
+// обходит биты e слева направо окнами не длиннее w бит, каждое из которых
+// кончается единицей: set/mul получают номер нечётной степени (v - 1) / 2
+template<typename SET, typename SQR, typename MUL>
+static void sliding_window(uint64_t e, int w, SET set, SQR sqr, MUL mul) {
+    int i = 63 - __builtin_clzll(e);
+    bool started = false;
+    while (i >= 0) {
+        if (((e >> i) & 1) == 0) {
+            sqr();
+            i--;
+            continue;
+        }
+        int l = std::max(i - w + 1, 0);
+        while (((e >> l) & 1) == 0) {
+            l++;
+        }
+        size_t v = static_cast<size_t>((e >> l) & ((static_cast<uint64_t>(2) << (i - l)) - 1));
+        if (started) {
+            for (int j = l; j <= i; j++) {
+                sqr();
+            }
+            mul(v >> 1);
+        } else {
+            set(v >> 1);
+            started = true;
+        }
+        i = l - 1;
+    }
+}
+
+big_integer pow(big_integer const &a, uint64_t e) {
+    if (e == 0) {
+        return 1;
+    }
+    big_integer base = a;
+    base.data_.positive = true;
+    if (base.is_zero()) {
+        return 0;
+    }
+    bool negative = !a.data_.positive && (e & 1);
+    // множитель 2^z уходит в сдвиг: a^e = b^e 2^(z e)
+    size_t zeros = 0;
+    u32 const *b = base.data_.span();
+    while (b[zeros / big_integer::BASE] == 0) {
+        zeros += big_integer::BASE;
+    }
+    zeros += __builtin_ctz(b[zeros / big_integer::BASE]);
+    if (zeros) {
+        base >>= static_cast<int>(zeros);
+    }
+    // b < 2^bits, значит b^e < 2^(bits e): длина известна заранее
+    size_t bits = base.bit_length();
+    if (e > std::numeric_limits<size_t>::max() / 2 / (bits + zeros)) {
+        throw std::length_error("pow: result too large");
+    }
+    size_t shift = zeros * e;
+    size_t n = (bits * e + shift) / big_integer::BASE + 2;
+    big_integer r;
+    r.data_.resize(n);
+    u32 *out = r.data_.mutable_span();
+    size_t len = 1;
+    if (bits == 1) {
+        out[0] = 1;
+    } else {
+        int ebits = 64 - __builtin_clzll(e);
+        int w = ebits < 8 ? 1 : ebits < 20 ? 2 : ebits < 40 ? 3 : 4;
+        std::vector<big_integer> odd(static_cast<size_t>(1) << (w - 1));
+        odd[0] = base;
+        if (odd.size() > 1) {
+            big_integer sq = base * base;
+            for (size_t i = 1; i < odd.size(); i++) {
+                odd[i] = odd[i - 1] * sq;
+            }
+        }
+        // результат бегает между out и tmp; начало выбирается так, чтобы
+        // последняя операция записала его в out
+        size_t steps = 0;
+        sliding_window(e, w, [](size_t) {}, [&] { steps++; }, [&](size_t) { steps++; });
+        scratch_mark mark;
+        u32 *tmp = mark.alloc(n);
+        u32 *cur = steps % 2 == 0 ? out : tmp;
+        u32 *other = steps % 2 == 0 ? tmp : out;
+        auto trim = [&](size_t m) {
+            while (m > 1 && cur[m - 1] == 0) {
+                m--;
+            }
+            len = m;
+        };
+        sliding_window(e, w, [&](size_t i) {
+            big_integer::cont const &g = odd[i].data_;
+            std::copy(g.span(), g.span() + g.size(), cur);
+            len = g.size();
+        }, [&] {
+            sqr_limbs(other, cur, len);
+            std::swap(cur, other);
+            trim(2 * len);
+        }, [&](size_t i) {
+            big_integer::cont const &g = odd[i].data_;
+            if (len >= g.size()) {
+                mul_limbs(other, cur, len, g.span(), g.size());
+            } else {
+                mul_limbs(other, g.span(), g.size(), cur, len);
+            }
+            std::swap(cur, other);
+            trim(len + g.size());
+        });
+    }
+    size_t off = shift / big_integer::BASE;
+    unsigned bit = shift % big_integer::BASE;
+    if (bit) {
+        out[off + len] = kernels().lshift(out + off, out, len, bit);
+    } else if (off) {
+        std::copy_backward(out, out + len, out + off + len);
+    }
+    std::fill(out, out + off, 0);
+    big_integer::to_fit(r.data_);
+    r.data_.positive = !negative;
+    return r;
+}
+
+// произведение v[lo, hi): половины по числу множителей, так что на каждом
+// уровне перемножаются числа близкой длины и работают быстрые умножения
+static big_integer product_tree(std::vector<big_integer> const &v, size_t lo, size_t hi) {
+    if (hi - lo == 1) {
+        return v[lo];
+    }
+    if (hi - lo == 2) {
+        return v[lo] * v[lo + 1];
+    }
+    size_t mid = lo + (hi - lo) / 2;
+    return product_tree(v, lo, mid) * product_tree(v, mid, hi);
+}
+
+big_integer product(std::vector<big_integer> const &factors) {
+    if (factors.empty()) {
+        return 1;
+    }
+    return product_tree(factors, 0, factors.size());
+}
+
+// маленькие множители сначала собираются в 64-битные листья
+big_integer big_integer::product_small(std::vector<u32> const &factors) {
+    std::vector<big_integer> leaves;
+    uint64_t acc = 1;
+    for (u32 f : factors) {
+        if (acc > std::numeric_limits<uint64_t>::max() / f) {
+            leaves.push_back(acc);
+            acc = 1;
+        }
+        acc *= f;
+    }
+    leaves.push_back(acc);
+    return product(leaves);
+}
+
+big_integer big_integer::factorial_swing(unsigned n, std::vector<u32> const &primes) {
+    if (n < 2) {
+        return 1;
+    }
+    // показатель p в swing(n) = n! / ((n / 2)!)^2 — число нечётных n / p^i,
+    // так что p^e <= n и множители помещаются в лимб
+    std::vector<u32> factors;
+    for (size_t i = 0; i < primes.size() && primes[i] <= n; i++) {
+        u32 p = primes[i];
+        u32 f = 1;
+        for (unsigned q = n / p; q != 0; q /= p) {
+            if (q & 1) {
+                f *= p;
+            }
+        }
+        if (f != 1) {
+            factors.push_back(f);
+        }
+    }
+    big_integer half = factorial_swing(n / 2, primes);
+    return half * half * product_small(factors);
+}
+
+big_integer factorial(unsigned n) {
+    return big_integer::factorial_swing(n, primes_up_to(n));
+}
+
+big_integer binomial(unsigned n, unsigned k) {
+    if (k > n) {
+        return 0;
+    }
+    // по Куммеру степень p — число переносов при сложении k и n - k в системе
+    // по основанию p, поэтому p^e <= n
+    std::vector<u32> factors;
+    for (u32 p : primes_up_to(n)) {
+        u32 f = 1;
+        for (uint64_t q = p; q <= n; q *= p) {
+            if (n / q - k / q - (n - k) / q) {
+                f *= p;
+            }
+        }
+        if (f != 1) {
+            factors.push_back(f);
+        }
+    }
+    return big_integer::product_small(factors);
+}
+
+big_integer primorial(unsigned n) {
+    return big_integer::product_small(primes_up_to(n));
+}
+
+// floor(a^(1/k)) для a < 2^64, k >= 2
+static uint64_t root_u64(uint64_t a, unsigned k) {
+    // x^k <= a без переполнения
+    auto fits = [a, k](uint64_t x) {
+        big_integer::uint128_t p = 1;
+        for (unsigned i = 0; i < k; i++) {
+            p *= x;
+            if (p > a) {
+                return false;
+            }
+        }
+        return true;
+    };
+    uint64_t r = static_cast<uint64_t>(std::pow(static_cast<double>(a), 1.0 / k));
+    while (r > 0 && !fits(r)) {
+        r--;
+    }
+    while (fits(r + 1)) {
+        r++;
+    }
+    return r;
+}
+
+size_t big_integer::bit_length() const {
+    size_t n = data_.size();
+    u32 top = data_[n - 1];
+    return top == 0 ? 0 : BASE * n - __builtin_clz(top);
+}
+
+// floor(a^(1/k)) для a >= 0. Начальное приближение — корень из старших бит
+// (рекурсивно), сдвинутый обратно: у него верна примерно половина бит, и с
+// запасом в log2(k) бит одна итерация Ньютона сверху ошибается не больше чем
+// на единицу. Вместо второго деления хватает проверки возведением в степень.
+// Каждый уровень вдвое короче предыдущего, так что всё стоит как несколько
+// делений и умножений полной длины
+big_integer big_integer::root(big_integer const &a, unsigned k) {
+    if (k == 1) {
+        return a;
+    }
+    size_t len = a.bit_length();
+    if (len <= 64) {
+        uint64_t v = a.data_[0];
+        if (a.data_.size() > 1) {
+            v |= static_cast<uint64_t>(a.data_[1]) << BASE;
+        }
+        return root_u64(v, k);
+    }
+    if (k >= len) {
+        return 1;
+    }
+    size_t bits = (len - 1) / k;
+    size_t margin = 32 - __builtin_clz(k);
+    size_t e = bits > margin ? (bits - margin) / 2 : 0;
+    big_integer r;
+    if (e == 0) {
+        r = big_integer(1) << static_cast<int>((len + k - 1) / k);
+    } else {
+        r = (root(a >> static_cast<int>(k * e), k) + 1) << static_cast<int>(e);
+    }
+    // итерация Ньютона монотонно убывает, пока не дойдёт до floor(a^(1/k))
+    big_integer km1 = static_cast<int>(k - 1);
+    big_integer kk = static_cast<int>(k);
+    while (true) {
+        big_integer y = k == 2 ? (r + a / r) >> 1 : (km1 * r + a / pow(r, k - 1)) / kk;
+        if (y >= r) {
+            return r;
+        }
+        if (pow(y, k) <= a) {
+            return y;
+        }
+        r = y - 1;
+        if (pow(r, k) <= a) {
+            return r;
+        }
+    }
+}
+
+big_integer isqrt(big_integer const &a) {
+    return iroot(a, 2);
+}
+
+big_integer iroot(big_integer const &a, unsigned k) {
+    if (k == 0 || (!a.data_.positive && k % 2 == 0)) {
+        throw std::domain_error("no real root");
+    }
+    if (!a.data_.positive) {
+        return -big_integer::root(-a, k);
+    }
+    return big_integer::root(a, k);
+}
+
+static bool is_prime_u32(u32 n) {
+    if (n < 2) {
+        return false;
+    }
+    for (u32 d = 2; d * d <= n; d++) {
+        if (n % d == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static u32 powmod_u32(u32 b, u32 e, u32 m) {
+    uint64_t r = 1;
+    uint64_t x = b % m;
+    for (; e != 0; e >>= 1) {
+        if (e & 1) {
+            r = r * x % m;
+        }
+        x = x * x % m;
+    }
+    return static_cast<u32>(r);
+}
+
+namespace {
+// квадратичные вычеты по модулям 64, 63, 65 и 11: вместе отсекают
+// больше 99% неквадратов за один проход mod_1
+struct square_residues {
+    bool mod64[64];
+    bool mod63[63];
+    bool mod65[65];
+    bool mod11[11];
+
+    square_residues() : mod64(), mod63(), mod65(), mod11() {
+        for (u32 i = 0; i < 65; i++) {
+            mod64[i * i % 64] = true;
+            mod63[i * i % 63] = true;
+            mod65[i * i % 65] = true;
+            mod11[i * i % 11] = true;
+        }
+    }
+};
+}
+
+bool is_perfect_square(big_integer const &a) {
+    static const square_residues sq;
+    if (!a.data_.positive) {
+        return false;
+    }
+    big_integer::cont const &d = a.data_;
+    if (!sq.mod64[d[0] & 63]) {
+        return false;
+    }
+    u32 r = mod_1(d.span(), d.size(), 63 * 65 * 11);
+    if (!sq.mod63[r % 63] || !sq.mod65[r % 65] || !sq.mod11[r % 11]) {
+        return false;
+    }
+    big_integer s = big_integer::root(a, 2);
+    return s * s == a;
+}
+
+bool is_perfect_power(big_integer const &a) {
+    big_integer x = a;
+    x.data_.positive = true;
+    if (x <= 1) {
+        return true;
+    }
+    size_t len = x.bit_length();
+    // показатель степени обязан делить число младших нулевых бит
+    big_integer::cont const &d = x.data_;
+    size_t zeros = 0;
+    while (d[zeros / big_integer::BASE] == 0) {
+        zeros += big_integer::BASE;
+    }
+    zeros += __builtin_ctz(d[zeros / big_integer::BASE]);
+    for (u32 p = 2; p < len; p++) {
+        if (!is_prime_u32(p) || (zeros != 0 && zeros % p != 0)) {
+            continue;
+        }
+        if (p == 2) {
+            if (a.data_.positive && is_perfect_square(x)) {
+                return true;
+            }
+            continue;
+        }
+        // p-я степень остаётся p-м вычетом по простым q = 2jp + 1,
+        // а случайное число проходит каждую такую проверку с вероятностью 1/p
+        bool residue = true;
+        int checked = 0;
+        for (uint64_t q = 2 * p + 1; residue && checked < 3 && q >> 32 == 0; q += 2 * p) {
+            if (is_prime_u32(static_cast<u32>(q))) {
+                u32 r = mod_1(d.span(), d.size(), static_cast<u32>(q));
+                residue = r == 0 || powmod_u32(r, static_cast<u32>((q - 1) / p), static_cast<u32>(q)) == 1;
+                checked++;
+            }
+        }
+        if (!residue) {
+            continue;
+        }
+        if (pow(big_integer::root(x, p), p) == x) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// x нечётно, больше TRIAL_DIVISION_LIMIT и без малых делителей
+bool big_integer::bpsw(big_integer const &x, int rounds) {
+    cont const &d = x.data_;
+    u32 const *m = d.span();
+    size_t n = d.size();
+    montgomery mt(m, n);
+    if (!miller_rabin(mt, m, 2) || is_perfect_square(x) || !strong_lucas(mt, m)) {
+        return false;
+    }
+    // основания зависят только от x, так что ответ воспроизводим
+    uint64_t state = m[0];
+    for (int i = 0; i < rounds; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        u32 r = static_cast<u32>(state >> 32);
+        u32 base = 2 + r % (n == 1 ? m[0] - 3 : MAX_DIGIT - 2);
+        if (!miller_rabin(mt, m, base)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool is_probable_prime(big_integer const &x, int rounds) {
+    if (!x.data_.positive) {
+        return false;
+    }
+    big_integer::cont const &d = x.data_;
+    if (d.size() == 1 && d[0] < TRIAL_DIVISION_LIMIT) {
+        std::vector<u32> const &primes = small_primes();
+        return std::binary_search(primes.begin(), primes.end(), d[0]);
+    }
+    if (has_small_factor(d.span(), d.size())) {
+        return false;
+    }
+    if (d.size() == 1 && d[0] < TRIAL_DIVISION_LIMIT * TRIAL_DIVISION_LIMIT) {
+        return true;
+    }
+    return big_integer::bpsw(x, rounds);
+}
+
+// сколько нечётных кандидатов просеивается за раз в next_prime
+static const size_t PRIME_SIEVE_WINDOW = 2048;
+
+big_integer next_prime(big_integer const &x) {
+    if (x < 2) {
+        return 2;
+    }
+    big_integer c = x + 1;
+    if ((c.data_.span()[0] & 1) == 0) {
+        c += 1;
+    }
+    for (; c < static_cast<int>(TRIAL_DIVISION_LIMIT); c += 2) {
+        if (is_probable_prime(c)) {
+            return c;
+        }
+    }
+    // решето по окну c, c + 2, ...: до BPSW доходит только то, что не делится
+    // ни на одно простое из таблицы
+    std::vector<u32> const &primes = small_primes();
+    std::vector<char> composite(PRIME_SIEVE_WINDOW);
+    while (true) {
+        std::fill(composite.begin(), composite.end(), 0);
+        big_integer::cont const &d = c.data_;
+        for (size_t j = 1; j < primes.size(); j++) {
+            u32 p = primes[j];
+            u32 r = mod_1(d.span(), d.size(), p);
+            // c + 2i = 0 (mod p) при i = -r / 2
+            for (size_t i = r == 0 ? 0 : (p - r) * ((p + 1) / 2) % p; i < PRIME_SIEVE_WINDOW; i += p) {
+                composite[i] = 1;
+            }
+        }
+        for (size_t i = 0; i < PRIME_SIEVE_WINDOW; i++) {
+            if (!composite[i]) {
+                big_integer candidate = c + static_cast<int>(2 * i);
+                if (big_integer::bpsw(candidate, 0)) {
+                    return candidate;
+                }
+            }
+        }
+        c += static_cast<int>(2 * PRIME_SIEVE_WINDOW);
+    }
+}
+
+std::vector<bool> is_probable_prime(std::vector<big_integer> const &xs, int rounds, size_t max_threads) {
+#ifdef BIGINT_ATOMIC_REFCOUNT
+    std::vector<big_integer> const &own = xs;
+#else
+    // у каждого потока свои копии с отдельными буферами: счётчик ссылок
+    // в cont не атомарный, а разделять буфер между потоками нельзя
+    std::vector<big_integer> own(xs.size());
+    for (size_t i = 0; i < xs.size(); i++) {
+        big_integer::cont const &d = xs[i].data_;
+        own[i].data_.resize(d.size());
+        std::copy(d.span(), d.span() + d.size(), own[i].data_.mutable_span());
+        own[i].data_.positive = xs[i].data_.positive;
+    }
+#endif
+    std::vector<char> result(xs.size());
+    std::atomic<size_t> next(0);
+    auto job = [&] {
+        for (size_t i; (i = next++) < own.size();) {
+            result[i] = is_probable_prime(own[i], rounds);
+        }
+    };
+    size_t threads = std::min(max_threads, xs.size());
+    if (threads > 1) {
+        thread_pool pool(threads - 1);
+        task_group group(pool);
+        for (size_t t = 1; t < threads; t++) {
+            group.run(job);
+        }
+        job();
+        group.wait();
+    } else {
+        job();
+    }
+    return std::vector<bool>(result.begin(), result.end());
+}
+
 pair<uint32_t, uint32_t> big_integer::split64(uint64_t n) {
     return {n & 0xFFFFFFFF, n >> 32};
 }
 
 void big_integer::sub_abs(big_integer const &b) {
-    bool loan = false;
-    cont t1;
-    cont t2;
-    if ((*this < b) ^ !positive) {
-        t1 = b.data_;
-        t2 = (*this).data_;
+    size_t n = data_.size();
+    size_t m = b.data_.size();
+    if ((*this < b) ^ !data_.positive) {
+        if (n < m)
+            data_.resize(m);
+        u32 *r = data_.mutable_span();
+        u32 const *a = b.data_.span();
+        u32 loan = kernels().sub_n(r, a, r, n);
+        for (size_t i = n; i < m; i++) {
+            r[i] = a[i] - loan;
+            loan = loan && a[i] == 0;
+        }
     } else {
-        t1 = (*this).data_;
-        t2 = b.data_;
-    }
-    if (t2.size() < t1.size()) {
-        t2.resize(t1.size());
-    }
-    for (size_t i = 0; i < t1.size(); i++) {
-        bool nLoan = t1[i] < t2[i];
-        t1[i] -= (t2[i] + loan);
-        loan = nLoan;
+        u32 *r = data_.mutable_span();
+        u32 loan = kernels().sub_n(r, r, b.data_.span(), m);
+        for (size_t i = m; loan && i < n; i++) {
+            loan = r[i] == 0;
+            r[i]--;
+        }
     }
-    (*this).data_ = t1;
     to_fit(data_);
 }
 void big_integer::sum_abs(big_integer const &b) {
-    if (data_.size() < b.data_.size())
-        data_.resize(b.data_.size());
-    bool over = false;
-    for (size_t i = 0; i < b.data_.size(); i++) {
-        auto p = split64(static_cast<uint64_t>(data_[i]) + b.data_[i] + over);
-        data_[i] = p.first;
-        over = p.second;
-    }
-    for (size_t i = b.data_.size(); i < data_.size(); i++) {
-        auto p = split64(static_cast<uint64_t>(data_[i]) + over);
-        data_[i] = p.first;
-        over = p.second;
+    size_t m = b.data_.size();
+    if (data_.size() < m)
+        data_.resize(m);
+    size_t n = data_.size();
+    u32 *r = data_.mutable_span();
+    u32 over = kernels().add_n(r, r, b.data_.span(), m);
+    for (size_t i = m; over && i < n; i++) {
+        over = ++r[i] == 0;
     }
     if (over) {
         data_.push_back(over);
     }
 }
 void big_integer::to_fit(cont &v) {
-    while (v.size() != 1 && v[v.size() - 1] == 0) {
-        v.pop_back();
+    u32 const *d = v.span();
+    size_t n = v.size();
+    while (n > 1 && d[n - 1] == 0) {
+        n--;
     }
+    v.truncate(n);
 }
 big_integer::cont big_integer::addition_to_2(cont const &v, bool is2) const {
     big_integer temp;
@@ -409,20 +1566,24 @@ big_integer::cont big_integer::addition_to_2(cont const &v, bool is2) const {
     if (!is2 && high) {
         temp.data_.push_back(0);
     }
-    if (!is2 && positive) {
+    if (!is2 && data_.positive) {
         return temp.data_;
     }
     if (is2 && !high) {
         return v;
     }
+    u32 *d = temp.data_.mutable_span();
     for (size_t i = 0; i < temp.data_.size(); i++){
-        temp.data_[i] = ~temp.data_[i];
+        d[i] = ~d[i];
     }
     temp++;
     return temp.data_;
 }
-bool big_integer::highBit(cont &v) {
-    return (v.back() & (static_cast<u32>(1) << (BASE - 1)));
+bool big_integer::is_zero() const {
+    return data_.size() == 1 && data_[0] == 0;
+}
+bool big_integer::highBit(cont const &v) {
+    return (v.span()[v.size() - 1] & (static_cast<u32>(1) << (BASE - 1)));
 }
 pair<big_integer, big_integer> big_integer::div(big_integer &v, big_integer const &d) {
     if (v.data_.size() < d.data_.size()) {
@@ -438,74 +1599,38 @@ pair<big_integer, big_integer> big_integer::div(big_integer &v, big_integer cons
     }
 }
 
-pair<big_integer, big_integer> big_integer::div_M_N(big_integer &v, big_integer const &d_) {
-    u32 i = 0;
-    auto d = d_;
-    d.positive = true;
-    u32 mask = 1 << (BASE - 1);
-    while ((d.data_.back() & mask) == 0) {
-        mask >>= 1;
-        i++;
-    }
-    v <<= i;
-    d <<= i;
-    int k = v.data_.size() - d.data_.size();
-    cont res;
-    big_integer dk = d << (int) (BASE * k);
-    if (v >= dk) {
-        res.push_back(1);
-        v -= dk;
-    } else {
-        res.push_back(0);
-    }
-    while (k != 0) {
-        k--;
-        dk = d << (int) (k * BASE);
-        if (v[-1] == d[-1] && v[-2] == d[-2]) {
-            res.push_back(0xFFFFFFFF);
-        } else {
-            auto p = div_3_2_primal(v[-1],
-                                    v[-2],
-                                    v[-3],
-                                    d[-1],
-                                    d[-2]);
-            res.push_back(p.first);
-        }
-        big_integer temp;
-        temp.data_[0] = res.back();
-        v -= temp * dk;
-        if (v < 0) {
-            v += d;
-            --res.back();
-        }
-    }
-    //std::reverse(res.begin(), res.end());
-    res.reverse();
-    big_integer result;
-    result.data_ = res;
-    to_fit(result.data_);
-    return {result, v >> i};
+pair<big_integer, big_integer> big_integer::div_M_N(big_integer &v, big_integer const &d) {
+    cont const &a = v.data_;
+    cont const &b = d.data_;
+    size_t n = a.size();
+    size_t m = b.size();
+    big_integer q;
+    big_integer r;
+    q.data_.resize(n - m + 1);
+    r.data_.resize(m);
+    divrem_limbs(q.data_.mutable_span(), r.data_.mutable_span(), a.span(), n, b.span(), m);
+    to_fit(q.data_);
+    to_fit(r.data_);
+    return {q, r};
 }
 
 pair<big_integer, big_integer> big_integer::div_N_1(big_integer &v, big_integer const &d) {
-    uint64_t carry = 0;
-    u32 di = d.data_[0];
-    for (size_t i = v.data_.size(); i != 0; --i) {
-        auto p = static_cast<uint64_t>(v.data_[i - 1]) + carry * BASE_DIGIT;
-        v.data_[i - 1] = split64(p / di).first;
-        carry = p % di;
-    }
+    u32 *a = v.data_.mutable_span();
+    big_integer rem;
+    rem.data_[0] = divrem_1(a, a, v.data_.size(), d.data_[0]);
     to_fit(v.data_);
-    return {v, carry};
+    return {v, rem};
 }
 pair<big_integer, big_integer> big_integer::div_primal(big_integer &v, big_integer const &d) {
     uint128_t t1 = 0;
     uint128_t t2 = 0;
+    u32 const *a = v.data_.span();
+    u32 const *b = d.data_.span();
     for (size_t i = 0; i < v.data_.size(); i++) {
-        t1 += static_cast<uint128_t>(v.data_[i]) << (BASE * i);
+        t1 += static_cast<uint128_t>(a[i]) << (BASE * i);
     }
     for (size_t i = 0; i < d.data_.size(); i++) {
-        t2 += static_cast<uint128_t>(d.data_[i]) << (BASE * i);
+        t2 += static_cast<uint128_t>(b[i]) << (BASE * i);
     }
     uint128_t r = t1 / t2;
     uint128_t m = t1 - r * t2;
@@ -513,41 +1638,27 @@ pair<big_integer, big_integer> big_integer::div_primal(big_integer &v, big_integ
     big_integer mod;
     res.data_.resize(4);
     mod.data_.resize(4);
+    u32 *rd = res.data_.mutable_span();
+    u32 *md = mod.data_.mutable_span();
     for (u32 i = 0; i < 4; i++) {
-        res.data_[i] = (r & (static_cast<uint128_t>(MAX_DIGIT) << (BASE * i))) >> (BASE * i);
-        mod.data_[i] = (m & (static_cast<uint128_t>(MAX_DIGIT) << (BASE * i))) >> (BASE * i);
+        rd[i] = (r & (static_cast<uint128_t>(MAX_DIGIT) << (BASE * i))) >> (BASE * i);
+        md[i] = (m & (static_cast<uint128_t>(MAX_DIGIT) << (BASE * i))) >> (BASE * i);
     }
     to_fit(res.data_);
     to_fit(mod.data_);
     return {res, mod};
 }
-pair<uint32_t, uint32_t> big_integer::div_3_2_primal(uint32_t u1, uint32_t u2, uint32_t u3, uint32_t d1, uint32_t d2) {
-    uint128_t t1 = 0;
-    uint128_t t2 = 0;
-    t1 += u3;
-    t1 += static_cast<uint128_t>(u2) << BASE;
-    t1 += static_cast<uint128_t>(u1) << (BASE * 2);
-    t2 += d2;
-    t2 += static_cast<uint128_t>(d1) << BASE;
-    uint128_t r = t1 / t2;
-    uint128_t m = t1 - r * t2;
-    u32 res = static_cast<u32>(r & MAX_DIGIT);
-    u32 mod = static_cast<u32>(m & MAX_DIGIT);
-    return {res, mod};
-}
-
-
-uint32_t big_integer::operator[](int i) {
-    if (i < 0) {
-        i = data_.size() + i;
-    }
-    if (i >= data_.size()) {
-        return 0;
-    } else {
-        return data_[i];
-    }
-}
 
 std::ostream &operator<<(std::ostream &s, big_integer const &a) {
     return s << to_string(a);
 }
+
+// FNV-1a по лимбам и знаку
+size_t std::hash<big_integer>::operator()(big_integer const &a) const {
+    u32 const *d = a.data_.span();
+    uint64_t h = 14695981039346656037ull ^ a.data_.positive;
+    for (size_t i = 0; i < a.data_.size(); i++) {
+        h = (h ^ d[i]) * 1099511628211ull;
+    }
+    return static_cast<size_t>(h);
+}
@@ -5,21 +5,49 @@
 #include <iosfwd>
 #include <vector>
 #include <cstdint>
+#include <functional>
+#include <random>
+#include <stdexcept>
 #include "container.h"
 
 using namespace std;
 
+struct lehmer_matrix;
+class tagged_integer;
+
 struct big_integer {
-     typedef unsigned __int128 uint128_t;
+     __extension__ typedef unsigned __int128 uint128_t;
+     __extension__ typedef __int128 int128_t;
      typedef container cont;
      //typedef vector<u32> cont;
      big_integer();
      big_integer(big_integer const &other);
+     // other становится нулём
+     big_integer(big_integer &&other) noexcept;
      big_integer(int a);
+     big_integer(unsigned a);
+     big_integer(long a);
+     big_integer(unsigned long a);
+     big_integer(long long a);
+     big_integer(unsigned long long a);
+     big_integer(int128_t a);
+     big_integer(uint128_t a);
+     // дробная часть отбрасывается; std::domain_error для nan и бесконечностей
+     explicit big_integer(double a);
      explicit big_integer(std::string const &str);
      ~big_integer();
 
      big_integer &operator=(big_integer const &other);
+     big_integer &operator=(big_integer &&other) noexcept;
+     void swap(big_integer &other) noexcept;
+
+     // вместимость в лимбах: до неё значение растёт без выделения памяти;
+     // как у std::vector, сама она не уменьшается, а арифметика пишет в
+     // имеющийся буфер. Присваивание берёт буфер правой части
+     size_t capacity() const;
+     void reserve(size_t limbs);
+     // отдаёт лишнюю память; значения до 64 бит переходят внутрь объекта
+     void shrink_to_fit();
 
      big_integer &operator+=(big_integer const &rhs);
      big_integer &operator-=(big_integer const &rhs);
@@ -44,6 +72,47 @@ struct big_integer {
      big_integer &operator--();
      big_integer operator--(int);
 
+     // равномерно на [0, 2^bits): лимбы заполняются прямо из генератора,
+     // по 64 бита за вызов
+     template<typename RNG>
+     static big_integer random_bits(size_t bits, RNG &&rng) {
+         big_integer r;
+         size_t n = (bits + BASE - 1) / BASE;
+         if (n == 0) {
+             return r;
+         }
+         r.data_.resize(n);
+         u32 *d = r.data_.mutable_span();
+         std::uniform_int_distribution<uint64_t> word;
+         for (size_t i = 0; i < n; i += 2) {
+             uint64_t w = word(rng);
+             d[i] = static_cast<u32>(w);
+             if (i + 1 < n) {
+                 d[i + 1] = static_cast<u32>(w >> BASE);
+             }
+         }
+         if (bits % BASE) {
+             d[n - 1] &= (1u << bits % BASE) - 1;
+         }
+         to_fit(r.data_);
+         return r;
+     }
+     // равномерно на [0, bound): random_bits по длине bound с отбраковкой,
+     // в среднем меньше двух попыток; bound > 0
+     template<typename RNG>
+     static big_integer random_below(big_integer const &bound, RNG &&rng) {
+         if (!bound.data_.positive || bound.is_zero()) {
+             throw std::domain_error("non-positive bound");
+         }
+         size_t bits = bound.bit_length();
+         while (true) {
+             big_integer r = random_bits(bits, rng);
+             if (r < bound) {
+                 return r;
+             }
+         }
+     }
+
      friend bool operator==(big_integer const &a, big_integer const &b);
      friend bool operator!=(big_integer const &a, big_integer const &b);
      friend bool operator<(big_integer const &a, big_integer const &b);
@@ -51,31 +120,75 @@ struct big_integer {
      friend bool operator<=(big_integer const &a, big_integer const &b);
      friend bool operator>=(big_integer const &a, big_integer const &b);
 
+     friend big_integer operator+(big_integer &&a, big_integer &&b);
+     friend big_integer operator-(big_integer const &a, big_integer &&b);
+     friend big_integer operator-(big_integer &&a, big_integer &&b);
+
      friend std::string to_string(big_integer const &a);
+     friend int64_t to_int64(big_integer const &a);
+     friend uint64_t to_uint64(big_integer const &a);
+     friend double to_double(big_integer const &a);
+     friend big_integer divexact(big_integer const &a, big_integer const &b);
+     friend big_integer gcd(big_integer const &a, big_integer const &b);
+     friend big_integer extended_gcd(big_integer const &a, big_integer const &b, big_integer &x, big_integer &y);
+     friend big_integer iroot(big_integer const &a, unsigned k);
+     friend big_integer pow(big_integer const &a, uint64_t e);
+     friend big_integer factorial(unsigned n);
+     friend big_integer binomial(unsigned n, unsigned k);
+     friend big_integer primorial(unsigned n);
+     friend bool is_perfect_square(big_integer const &a);
+     friend bool is_perfect_power(big_integer const &a);
+     friend bool is_probable_prime(big_integer const &x, int rounds);
+     friend big_integer next_prime(big_integer const &x);
+     friend std::vector<bool> is_probable_prime(std::vector<big_integer> const &xs, int rounds, size_t max_threads);
+     friend big_integer parallel_mul(big_integer const &a, big_integer const &b, size_t max_threads);
+     friend class tagged_integer;
+     friend struct std::hash<big_integer>;
 
  private:
+     // знак хранится в слове заголовка data_ (data_.positive)
      cont data_;
-     bool positive;
      static const uint32_t BASE = 32;
      static const uint32_t MAX_DIGIT = (((uint64_t) 1) << BASE) - 1;
      static const uint64_t BASE_DIGIT = ((uint64_t) 1) << BASE;
      static pair<uint32_t, uint32_t> split64(uint64_t n);
-     //uint32_t get(int i);
-     uint32_t operator[](int i);
      void sum_abs(big_integer const &b);
      void sub_abs(big_integer const &b);
      static void to_fit(cont &v);
+     void set_small(uint128_t v, bool sign);
+     void negate();
      cont addition_to_2(cont const &v, bool is2 = false) const;
-     static bool highBit(cont &v);
+     static bool highBit(cont const &v);
+     bool is_zero() const;
+     static big_integer multiply(big_integer const &a, big_integer const &b, size_t max_threads);
      static pair<big_integer, big_integer> div(big_integer &v, big_integer const &d);
      static pair<big_integer, big_integer> div_M_N(big_integer &v, big_integer const &d);
      static pair<big_integer, big_integer> div_primal(big_integer &v, big_integer const &d);
-     static pair<uint32_t, uint32_t> div_3_2_primal(uint32_t u1, uint32_t u2, uint32_t u3, uint32_t d1, uint32_t d2);
      static pair<big_integer, big_integer> div_N_1(big_integer &v, big_integer const &d);
+     static big_integer euclid_step(big_integer &a, big_integer &b);
+     static bool lehmer_reduce(big_integer &a, big_integer &b, lehmer_matrix &l);
+     static void lehmer_combine(big_integer &x, big_integer &y, lehmer_matrix const &l);
+     static void to_matrix(lehmer_matrix const &l, big_integer *m);
+     static void hgcd(big_integer &a, big_integer &b, big_integer *m);
+     static void gcd_reduce(big_integer &a, big_integer &b, big_integer *u);
+     size_t bit_length() const;
+     static big_integer product_small(std::vector<u32> const &factors);
+     static big_integer factorial_swing(unsigned n, std::vector<u32> const &primes);
+     static big_integer root(big_integer const &a, unsigned k);
+     static bool bpsw(big_integer const &x, int rounds);
 };
 
+void swap(big_integer &a, big_integer &b) noexcept;
+
 big_integer operator+(big_integer a, big_integer const &b);
 big_integer operator-(big_integer a, big_integer const &b);
+// временные операнды: результат пишется в буфер одного из них, при двух
+// временных — в более длинный, так что a * b + c * d выделяет память только
+// под произведения
+big_integer operator+(big_integer const &a, big_integer &&b);
+big_integer operator+(big_integer &&a, big_integer &&b);
+big_integer operator-(big_integer const &a, big_integer &&b);
+big_integer operator-(big_integer &&a, big_integer &&b);
 big_integer operator*(big_integer a, big_integer const &b);
 big_integer operator/(big_integer a, big_integer const &b);
 big_integer operator%(big_integer a, big_integer const &b);
@@ -84,6 +197,46 @@ big_integer operator&(big_integer a, big_integer const &b);
 big_integer operator|(big_integer a, big_integer const &b);
 big_integer operator^(big_integer a, big_integer const &b);
 
+// a / b, если заранее известно, что b делит a нацело; иначе результат не определён;
+// std::domain_error при b = 0
+big_integer divexact(big_integer const &a, big_integer const &b);
+// НОД |a| и |b|; gcd(0, 0) = 0
+big_integer gcd(big_integer const &a, big_integer const &b);
+// НОД g и коэффициенты a x + b y = g, |x| <= |b| / 2g
+big_integer extended_gcd(big_integer const &a, big_integer const &b, big_integer &x, big_integer &y);
+// x из [0, |m|) с a x = 1 (mod m); std::domain_error, если НОД(a, m) != 1
+big_integer mod_inverse(big_integer const &a, big_integer const &m);
+// a^e скользящим окном по битам e; буфер под результат выделяется один раз
+big_integer pow(big_integer const &a, uint64_t e);
+// произведение всех множителей деревом: соседние пары, потом пары пар и т. д.
+big_integer product(std::vector<big_integer> const &factors);
+template<typename It>
+big_integer product(It first, It last) {
+    return product(std::vector<big_integer>(first, last));
+}
+// n! по качающемуся множителю Луксона: n! = ((n / 2)!)^2 * swing(n)
+big_integer factorial(unsigned n);
+// C(n, k) по разложению на простые (теорема Куммера); 0 при k > n
+big_integer binomial(unsigned n, unsigned k);
+// произведение простых, не превосходящих n
+big_integer primorial(unsigned n);
+// floor(sqrt(a)), a >= 0
+big_integer isqrt(big_integer const &a);
+// целая часть корня k-й степени с округлением к нулю; k >= 1, для чётного k a >= 0
+big_integer iroot(big_integer const &a, unsigned k);
+bool is_perfect_square(big_integer const &a);
+// a = b^k при некотором k >= 2; 0, 1 и -1 считаются степенями
+bool is_perfect_power(big_integer const &a);
+// BPSW: пробное деление, сильные тесты Ферма по основанию 2 и Люка, затем ещё
+// rounds тестов Миллера—Рабина по псевдослучайным основаниям; x < 2 — не простое
+bool is_probable_prime(big_integer const &x, int rounds = 0);
+// наименьшее вероятно простое число, большее x
+big_integer next_prime(big_integer const &x);
+// is_probable_prime для каждого кандидата, кандидаты делятся между max_threads потоками
+std::vector<bool> is_probable_prime(std::vector<big_integer> const &xs, int rounds, size_t max_threads);
+// умножение на общем пуле (set_mul_threads), занимает не больше max_threads потоков
+big_integer parallel_mul(big_integer const &a, big_integer const &b, size_t max_threads);
+
 big_integer operator<<(big_integer a, int b);
 big_integer operator>>(big_integer a, int b);
 
@@ -95,6 +248,18 @@ bool operator<=(big_integer const &a, big_integer const &b);
 bool operator>=(big_integer const &a, big_integer const &b);
 
 std::string to_string(big_integer const &a);
+// std::out_of_range, если значение не помещается в тип
+int64_t to_int64(big_integer const &a);
+uint64_t to_uint64(big_integer const &a);
+// ближайшее double, при равенстве — с чётной мантиссой; inf при переполнении
+double to_double(big_integer const &a);
 std::ostream &operator<<(std::ostream &s, big_integer const &a);
 
+namespace std {
+template<>
+struct hash<big_integer> {
+    size_t operator()(big_integer const &a) const;
+};
+}
+
 #endif // BIG_INTEGER_H
@@ -0,0 +1,387 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "big_integer.h"
+#include "big_integer_gmp.h"
+#include "limb_div.h"
+#include "limb_kernels.h"
+#include "limb_mul.h"
+#include "limb_pool.h"
+#include "tagged_integer.h"
+
+namespace {
+template<typename F>
+double measure(F&& f, int reps) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i != reps; ++i)
+    f();
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / reps;
+}
+
+std::vector<u32> random_limbs(size_t n, std::mt19937_64& rng) {
+  std::vector<u32> v(n);
+  for (auto& x : v)
+    x = static_cast<u32>(rng());
+  return v;
+}
+
+void bench_parallel_mul(size_t an, size_t bn, int reps) {
+  std::mt19937_64 rng(an * 31 + bn);
+  std::vector<u32> a = random_limbs(an, rng);
+  std::vector<u32> b = random_limbs(bn, rng);
+  std::vector<u32> r(an + bn);
+  std::printf("mul %zu x %zu limbs\n", an, bn);
+  double base = 0;
+  size_t threads[] = {1, 2, 4, 8, 16};
+  for (size_t t : threads) {
+    set_mul_threads(t);
+    double ms = measure([&] { mul_limbs_parallel(r.data(), a.data(), an, b.data(), bn, t); }, reps);
+    if (t == 1)
+      base = ms;
+    std::printf("  %2zu threads: %10.2f ms  x%.2f\n", t, ms, base / ms);
+  }
+  set_mul_threads(1);
+}
+
+void bench_divexact(size_t qn, size_t dn, int reps) {
+  std::mt19937_64 rng(qn * 17 + dn);
+  std::vector<u32> q = random_limbs(qn, rng);
+  std::vector<u32> d = random_limbs(dn, rng);
+  d[0] |= 1;
+  d[dn - 1] |= 1;
+  std::vector<u32> a(qn + dn);
+  mul_limbs(a.data(), q.data(), qn, d.data(), dn);
+  size_t an = a.back() ? a.size() : a.size() - 1;
+  std::vector<u32> quot(an - dn + 1), rem(dn);
+  double full = measure([&] { divrem_limbs(quot.data(), rem.data(), a.data(), an, d.data(), dn); }, reps);
+  double exact = measure([&] { divexact_limbs(quot.data(), a.data(), an, d.data(), dn); }, reps);
+  std::printf("div %zu / %zu limbs: divrem %.3f ms, divexact %.3f ms  x%.2f\n", an, dn, full, exact, full / exact);
+}
+
+// exactly `bits` bits long
+big_integer random_big(size_t bits, std::mt19937_64& rng) {
+  return big_integer::random_bits(bits - 1, rng) + (big_integer(1) << static_cast<int>(bits - 1));
+}
+
+void bench_gcd(size_t bits, int reps) {
+  std::mt19937_64 rng(bits);
+  big_integer a = random_big(bits, rng);
+  big_integer b = random_big(bits, rng);
+  big_integer g;
+  double fast = measure([&] { g = gcd(a, b); }, reps);
+  double naive = measure([&] {
+    big_integer x = a, y = b;
+    while (y != 0) {
+      big_integer t = x % y;
+      x = y;
+      y = t;
+    }
+    g = x;
+  }, reps);
+  std::printf("gcd %zu bits: %.3f ms, %% loop %.3f ms  x%.2f\n", bits, fast, naive, naive / fast);
+}
+
+void bench_pow(int base, uint64_t e, bool naive) {
+  big_integer b = base;
+  big_integer r;
+  double fast = measure([&] { r = pow(b, e); }, 1);
+  if (!naive) {
+    std::printf("pow %d^%llu: %.3f ms\n", base, static_cast<unsigned long long>(e), fast);
+    return;
+  }
+  double slow = measure([&] {
+    r = 1;
+    for (uint64_t i = 0; i < e; i++)
+      r *= b;
+  }, 1);
+  std::printf("pow %d^%llu: %.3f ms, *= loop %.3f ms  x%.2f\n", base, static_cast<unsigned long long>(e), fast, slow,
+              slow / fast);
+}
+
+void bench_factorial(unsigned n) {
+  big_integer f;
+  double fast = measure([&] { f = factorial(n); }, 1);
+  double slow = measure([&] {
+    f = 1;
+    for (unsigned i = 2; i <= n; i++)
+      f *= static_cast<int>(i);
+  }, 1);
+  std::printf("factorial %u: %.3f ms, *= loop %.3f ms  x%.2f\n", n, fast, slow, slow / fast);
+}
+
+void bench_isqrt(size_t bits, int reps) {
+  std::mt19937_64 rng(bits + 1);
+  big_integer a = random_big(bits, rng);
+  big_integer b = random_big(bits, rng);
+  big_integer r;
+  double root = measure([&] { r = isqrt(a); }, reps);
+  double mul = measure([&] { r = a * b; }, reps);
+  std::printf("isqrt %zu bits: %.3f ms = %.1f multiplications\n", bits, root, root / mul);
+}
+
+void bench_random(size_t bits, int reps) {
+  std::mt19937_64 rng(bits + 3);
+  big_integer x;
+  double fast = measure([&] { x = big_integer::random_bits(bits, rng); }, reps);
+  double slow = measure([&] {
+    x = 0;
+    for (size_t i = 0; i < bits; i += 31) {
+      x <<= 31;
+      x += static_cast<int>(rng() & 0x7FFFFFFF);
+    }
+  }, reps);
+  std::printf("random %zu bits: %.4f ms, shift-add loop %.3f ms  x%.1f\n", bits, fast, slow, slow / fast);
+}
+
+// values that fit in 64 bits, as most production values do
+void bench_small(size_t count) {
+  std::mt19937_64 rng(40);
+  std::vector<big_integer> v;
+  for (size_t i = 0; i <= count; i++)
+    v.push_back(static_cast<int64_t>(rng()) >> (rng() % 48));
+  big_integer r;
+  bool less = false;
+  auto per_op = [&](double ms) { return ms * 1e6 / count; };
+  double add = measure([&] { for (size_t i = 0; i < count; i++) r = v[i] + v[i + 1]; }, 1);
+  double sub = measure([&] { for (size_t i = 0; i < count; i++) r = v[i] - v[i + 1]; }, 1);
+  double mul = measure([&] { for (size_t i = 0; i < count; i++) r = v[i] * v[i + 1]; }, 1);
+  double div = measure([&] { for (size_t i = 0; i < count; i++) r = v[i] / (v[i + 1] | 1); }, 1);
+  double cmp = measure([&] { for (size_t i = 0; i < count; i++) less ^= v[i] < v[i + 1]; }, 1);
+  std::printf("64-bit values: + %.1f ns, - %.1f ns, * %.1f ns, / %.1f ns, < %.1f ns%s\n", per_op(add), per_op(sub),
+              per_op(mul), per_op(div), per_op(cmp), less ? "" : " ");
+}
+
+// the bench_small workload on one-word values
+void bench_tagged(size_t count) {
+  std::mt19937_64 rng(40);
+  std::vector<tagged_integer> v;
+  for (size_t i = 0; i <= count; i++)
+    v.push_back(static_cast<int64_t>(rng()) >> (rng() % 48));
+  tagged_integer r;
+  bool less = false;
+  auto per_op = [&](double ms) { return ms * 1e6 / count; };
+  double add = measure([&] { for (size_t i = 0; i < count; i++) r = v[i] + v[i + 1]; }, 1);
+  double sub = measure([&] { for (size_t i = 0; i < count; i++) r = v[i] - v[i + 1]; }, 1);
+  double mul = measure([&] { for (size_t i = 0; i < count; i++) r = v[i] * v[i + 1]; }, 1);
+  double div = measure([&] { for (size_t i = 0; i < count; i++) r = v[i] / (v[i + 1] * 2 + 1); }, 1);
+  double cmp = measure([&] { for (size_t i = 0; i < count; i++) less ^= v[i] < v[i + 1]; }, 1);
+  std::printf("tagged (%zu vs %zu bytes): + %.1f ns, - %.1f ns, * %.1f ns, / %.1f ns, < %.1f ns%s\n",
+              sizeof(tagged_integer), sizeof(big_integer), per_op(add), per_op(sub), per_op(mul), per_op(div),
+              per_op(cmp), less ? "" : " ");
+}
+
+// temporaries of a few hundred bits, where allocation is a large share of the cost
+void bench_pool(size_t count) {
+  std::mt19937_64 rng(48);
+  std::vector<big_integer> v;
+  for (size_t i = 0; i <= 64; i++)
+    v.push_back(random_big(64 + rng() % 448, rng));
+  auto run = [&] {
+    big_integer acc;
+    for (size_t i = 0; i < count; i++) {
+      big_integer const& a = v[i % 64];
+      big_integer const& b = v[i % 64 + 1];
+      acc += (a * b >> 100) - (a << 7) + b / 12345;
+    }
+    return acc;
+  };
+  size_t limit = pool_limit();
+  set_pool_limit(0);
+  pool_trim();
+  double heap = measure(run, 1);
+  set_pool_limit(limit);
+  pool_stats before = pool_statistics();
+  double pooled = measure(run, 1);
+  pool_stats after = pool_statistics();
+  double hits = static_cast<double>(after.hits - before.hits);
+  double total = hits + static_cast<double>(after.misses - before.misses);
+  std::printf("mixed ops on 64..512 bits: heap %.1f ns, pool %.1f ns  x%.2f; %.1f%% hits, %zu bytes retained\n",
+              heap * 1e6 / count, pooled * 1e6 / count, heap / pooled, 100 * hits / total, after.retained);
+}
+
+// long-running accumulators: a sum over mixed signs and a Horner loop that
+// grows by one limb every few steps; allocations are counted by the pool
+void bench_accumulate(size_t count) {
+  std::mt19937_64 rng(50);
+  std::vector<big_integer> v;
+  for (size_t i = 0; i < 64; i++) {
+    big_integer x = random_big(64 + rng() % 448, rng);
+    v.push_back(i % 3 ? x : -x);
+  }
+  big_integer base = 1000000007;
+  auto report = [&](char const* name, size_t ops, std::function<big_integer()> run) {
+    pool_stats before = pool_statistics();
+    double t = measure(run, 1);
+    pool_stats after = pool_statistics();
+    double allocs = static_cast<double>(after.hits + after.misses - before.hits - before.misses);
+    std::printf("%s: %.1f ns/op, %.4f allocations/op\n", name, t * 1e6 / ops, allocs / ops);
+  };
+  report("sum += x", count, [&] {
+    big_integer acc;
+    for (size_t i = 0; i < count; i++)
+      acc += v[i % 64];
+    return acc;
+  });
+  size_t steps = count / 100;
+  report("horner acc = acc * b + d", steps, [&] {
+    big_integer acc;
+    for (size_t i = 0; i < steps; i++) {
+      acc *= base;
+      acc += v[i % 64];
+    }
+    return acc;
+  });
+  report("horner, reserved", steps, [&] {
+    big_integer acc;
+    acc.reserve(steps + 1);
+    for (size_t i = 0; i < steps; i++) {
+      acc *= base;
+      acc += v[i % 64];
+    }
+    return acc;
+  });
+}
+
+// operands long enough for Karatsuba and schoolbook division, short enough that
+// the temporaries are a visible share of the cost
+void bench_scratch(size_t limbs, int reps) {
+  std::mt19937_64 rng(limbs + 49);
+  big_integer a = random_big(32 * limbs, rng);
+  big_integer b = random_big(32 * limbs, rng);
+  big_integer c = a * b + a;
+  big_integer r;
+  double mul = measure([&] { r = a * b; }, reps);
+  double sqr = measure([&] { r = a * a; }, reps);
+  double div = measure([&] { r = c / b; }, reps);
+  std::printf("%zu limbs: mul %.2f us, sqr %.2f us, div %.2f us\n", limbs, mul * 1e3, sqr * 1e3, div * 1e3);
+}
+
+// run both big_integer_benchmark and big_integer_benchmark_atomic to compare
+void bench_sharing(size_t count) {
+#ifdef BIGINT_ATOMIC_REFCOUNT
+  std::printf("refcount: atomic\n");
+#else
+  std::printf("refcount: plain\n");
+#endif
+  big_integer x = big_integer(1) << 32000;
+  auto per_op = [&](double ms) { return ms * 1e6 / count; };
+  double copy = measure([&] {
+    for (size_t i = 0; i < count; i++) {
+      big_integer y = x;
+    }
+  }, 1);
+  big_integer a = big_integer(1) << 100, b = 12345;
+  double cow = measure([&] {
+    for (size_t i = 0; i < count; i++) {
+      big_integer y = a;
+      y += b;
+    }
+  }, 1);
+  std::printf("  copy + destroy %.1f ns, copy + write %.1f ns", per_op(copy), per_op(cow));
+#ifdef BIGINT_ATOMIC_REFCOUNT
+  // every thread copies the same value, so all of them hit one counter
+  std::vector<std::thread> threads;
+  double shared = measure([&] {
+    for (int t = 0; t < 4; t++)
+      threads.emplace_back([&] {
+        for (size_t i = 0; i < count / 4; i++) {
+          big_integer y = x;
+        }
+      });
+    for (auto& t : threads)
+      t.join();
+  }, 1);
+  std::printf(", 4 threads sharing one value %.1f ns", per_op(shared));
+#endif
+  std::printf("\n");
+}
+
+// mpz_probab_prime_p with reps = 25 is BPSW plus one Miller-Rabin round
+void bench_primality(size_t bits, size_t count) {
+  std::mt19937_64 rng(bits + 2);
+  std::vector<big_integer> candidates, primes;
+  std::vector<big_integer_gmp> candidates_gmp, primes_gmp;
+  for (size_t i = 0; i < count; i++) {
+    candidates.push_back(random_big(bits, rng) * 2 + 1);
+    candidates_gmp.emplace_back(to_string(candidates.back()));
+    if (i % 16 == 0) {
+      primes.push_back(next_prime(candidates.back()));
+      primes_gmp.emplace_back(to_string(primes.back()));
+    }
+  }
+  size_t found = 0;
+  double ours = measure([&] { for (auto& c : candidates) found += is_probable_prime(c, 1); }, 1);
+  double gmp = measure([&] { for (auto& c : candidates_gmp) found += probab_prime(c, 25) != 0; }, 1);
+  double ours_prime = measure([&] { for (auto& p : primes) found += is_probable_prime(p, 1); }, 1);
+  double gmp_prime = measure([&] { for (auto& p : primes_gmp) found += probab_prime(p, 25) != 0; }, 1);
+  double batch = measure([&] { found += is_probable_prime(candidates, 1, 8).size(); }, 1);
+  std::printf("primality %zu bits, %zu odd candidates: %.3f ms, gmp %.3f ms, 8 threads %.3f ms; "
+              "per prime %.3f ms, gmp %.3f ms (%zu)\n",
+              bits, count, ours, gmp, batch, ours_prime / primes.size(), gmp_prime / primes.size(), found);
+}
+}
+
+int main(int argc, char* argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "sharing") {
+    bench_sharing(10000000);
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "primality") {
+    bench_primality(512, 4000);
+    bench_primality(1024, 2000);
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "accumulate") {
+    bench_accumulate(1000000);
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "scratch") {
+    bench_scratch(100, 20000);
+    bench_scratch(1000, 500);
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "pool") {
+    bench_pool(1000000);
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "small") {
+    bench_small(1000000);
+    bench_tagged(1000000);
+    return 0;
+  }
+  size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  int reps = argc > 2 ? std::atoi(argv[2]) : 3;
+  std::printf("kernels: %s\n", kernel_tier_name(kernels().tier));
+  bench_parallel_mul(n, n, reps);
+  bench_parallel_mul(n, n / 200, reps);
+  bench_divexact(2000, 1000, 20 * reps);
+  bench_divexact(4000, 100, 20 * reps);
+  bench_gcd(3000, 20 * reps);
+  bench_gcd(30000, reps);
+  bench_gcd(300000, 1);
+  bench_pow(3, 100000, true);
+  bench_pow(3, 1000000, false);
+  bench_factorial(100000);
+  bench_isqrt(3000, 20 * reps);
+  bench_isqrt(300000, reps);
+  bench_small(1000000);
+  bench_tagged(1000000);
+  bench_pool(1000000);
+  bench_scratch(100, 20000);
+  bench_scratch(1000, 500);
+  bench_accumulate(1000000);
+  bench_sharing(10000000);
+  bench_random(3000, 20 * reps);
+  bench_random(100000, reps);
+  bench_primality(512, 4000);
+  bench_primality(1024, 2000);
+  bench_primality(4096, 200);
+  return 0;
+}
@@ -195,6 +195,16 @@ std::string to_string(big_integer_gmp const& a) {
   return res;
 }
 
+big_integer_gmp gcd(big_integer_gmp const& a, big_integer_gmp const& b) {
+  big_integer_gmp r;
+  mpz_gcd(r.mpz, a.mpz, b.mpz);
+  return r;
+}
+
+int probab_prime(big_integer_gmp const& a, int reps) {
+  return mpz_probab_prime_p(a.mpz, reps);
+}
+
 std::ostream& operator<<(std::ostream& s, big_integer_gmp const& a) {
   return s << to_string(a);
 }
\ No newline at end of file
@@ -59,6 +59,8 @@ struct big_integer_gmp {
   friend bool operator>=(big_integer_gmp const& a, big_integer_gmp const& b);
 
   friend std::string to_string(big_integer_gmp const& a);
+  friend big_integer_gmp gcd(big_integer_gmp const& a, big_integer_gmp const& b);
+  friend int probab_prime(big_integer_gmp const& a, int reps);
 
  private:
   mpz_t mpz;
@@ -85,6 +87,8 @@ bool operator<=(big_integer_gmp const& a, big_integer_gmp const& b);
 bool operator>=(big_integer_gmp const& a, big_integer_gmp const& b);
 
 std::string to_string(big_integer_gmp const& a);
+big_integer_gmp gcd(big_integer_gmp const& a, big_integer_gmp const& b);
+int probab_prime(big_integer_gmp const& a, int reps);
 std::ostream& operator<<(std::ostream& s, big_integer_gmp const& a);
 
 #endif // BIG_INTEGER_GMP_H
\ No newline at end of file
@@ -1,13 +1,24 @@
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
 #include <cstdlib>
 #include <random>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
 #include <vector>
 #include <utility>
 #include <gtest/gtest.h>
 
 #include "big_integer.h"
 #include "big_integer_gmp.h"
+#include "limb_kernels.h"
+#include "limb_mul.h"
+#include "limb_pool.h"
+#include "limb_scratch.h"
+#include "tagged_integer.h"
 
 TEST(correctness, two_plus_two) {
   EXPECT_EQ(big_integer(4), big_integer(2) + big_integer(2));
@@ -646,15 +657,10 @@ TEST(correctness, mul_merge_randomized) {
 }
 
 namespace {
-big_integer rand_big(size_t size) {
-  big_integer result = rand();
-
-  for (size_t i = 0; i != size; ++i) {
-    result *= RAND_MAX;
-    result += rand();
-  }
+std::mt19937_64 rand_big_engine(651);
 
-  return result;
+big_integer rand_big(size_t size) {
+  return big_integer::random_bits(31 * (size + 1), rand_big_engine);
 }
 }
 
@@ -670,6 +676,30 @@ TEST(correctness, div_randomized) {
   }
 }
 
+TEST(correctness, div_add_back_cases) {
+  // divisors with saturated or minimal top limbs make the quotient digit
+  // estimate overshoot and exercise the add-back step
+  std::string divisors[] = {"340282366920938463463374607431768211455",           // 2^128 - 1
+                            "170141183460469231731687303715884105729",           // 2^127 + 1
+                            "340282366920938463444927863358058659840",           // 2^128 - 2^64
+                            "6277101735386680763835789423207666416102355444464034512895", // 2^192 - 1
+                            "79228162514264337593543950337"};                    // 2^96 + 1
+  std::string dividends[] = {"115792089237316195423570985008687907853269984665640564039457584007913129639935",
+                             "115792089237316195423570985008687907852929702298719625575994209400481361428480",
+                             "57896044618658097711785492504343953926634992332820282019728792003956564819968",
+                             "39402006196394479212279040100143613805079739270465446667948293404245721771497210611414266254884915640806627990306815"};
+  for (auto const& ds : divisors) {
+    for (auto const& as : dividends) {
+      big_integer a(as), d(ds);
+      big_integer_gmp ga(as), gd(ds);
+      EXPECT_EQ(to_string(ga / gd), to_string(a / d));
+      EXPECT_EQ(to_string(ga % gd), to_string(a % d));
+      EXPECT_EQ(to_string(-ga % gd), to_string(-a % d));
+      EXPECT_EQ(a, a / d * d + a % d);
+    }
+  }
+}
+
 // y2019 tests
 
 TEST(correctness_random, cmp) {
@@ -789,6 +819,960 @@ TEST(correctness_random, bit_shifts) {
   }
 }
 
+TEST(correctness_random, div_single_limb) {
+  std::string divisors[] = {"1", "3", "10", "1000000000", "2147483648", "2147483647", "4294967295", "-4294967291"};
+  std::default_random_engine rng(31);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a;
+    a.random(max_size, rng);
+    big_integer A(to_string(a));
+    EXPECT_EQ(to_string(a), to_string(A));
+    for (auto const& ds : divisors) {
+      big_integer_gmp d(ds);
+      EXPECT_EQ(to_string(a / d), to_string(A / big_integer(ds)));
+      EXPECT_EQ(to_string(a % d), to_string(A % big_integer(ds)));
+    }
+  }
+}
+
+TEST(correctness_random, divexact) {
+  std::default_random_engine rng(32);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b;
+    a.random(max_size, rng);
+    b.random(max_size / 4, rng);
+    b <<= static_cast<int>(itn * 7);
+    if (b == 0)
+      continue;
+    big_integer A(to_string(a));
+    big_integer B(to_string(b));
+    big_integer P = A * B;
+    EXPECT_EQ(to_string(a), to_string(divexact(P, B)));
+    EXPECT_EQ(to_string(b), to_string(divexact(P, A)));
+    EXPECT_EQ(to_string(-a), to_string(divexact(-P, B)));
+  }
+  EXPECT_EQ(0, divexact(0, 5));
+  EXPECT_EQ(-3, divexact(12, -4));
+  EXPECT_THROW(divexact(0, 0), std::domain_error);
+  EXPECT_THROW(divexact(big_integer(1) << 100, 0), std::domain_error);
+  EXPECT_EQ(big_integer("18446744073709551616"), divexact(big_integer("79228162514264337593543950336"), big_integer("4294967296")));
+}
+
+TEST(correctness_random, gcd) {
+  // the common factor makes the gcd nontrivial; the longest inputs take the half-gcd path
+  size_t sizes[] = {40, 100, 200, 1000, 3000, 20000, 100000};
+  std::default_random_engine rng(33);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    for (size_t sz : sizes) {
+      if (sz > max_size * 10 && itn % 4 != 0)
+        continue;
+      big_integer_gmp a, b, c;
+      a.random(sz, rng);
+      b.random(sz - sz / 3 * (itn % 3), rng);
+      c.random(sz / 4 * (itn % 4), rng);
+      a *= c;
+      b *= c;
+      big_integer A(to_string(a));
+      big_integer B(to_string(b));
+      big_integer G = gcd(A, B);
+      EXPECT_EQ(to_string(gcd(a, b)), to_string(G));
+      big_integer x, y;
+      EXPECT_EQ(G, extended_gcd(A, B, x, y));
+      EXPECT_EQ(G, A * x + B * y);
+      if (B != 0) {
+        EXPECT_LE(2 * G * (x < 0 ? -x : x), B < 0 ? -B : B);
+      }
+    }
+  }
+}
+
+namespace {
+// (F(n), F(n + 1)) by fast doubling
+std::pair<big_integer, big_integer> fibonacci(unsigned n) {
+  if (n == 0)
+    return {0, 1};
+  auto p = fibonacci(n / 2);
+  big_integer c = p.first * (2 * p.second - p.first);
+  big_integer d = p.first * p.first + p.second * p.second;
+  if (n % 2 == 0)
+    return {c, d};
+  return {d, c + d};
+}
+}
+
+TEST(correctness, gcd_special) {
+  // consecutive Fibonacci numbers: every quotient is 1
+  auto fib = fibonacci(120000);
+  big_integer f0 = fib.first, f1 = fib.second;
+  EXPECT_EQ(1, gcd(f1, f0));
+  big_integer x, y;
+  EXPECT_EQ(1, extended_gcd(f1, f0, x, y));
+  EXPECT_EQ(1, f1 * x + f0 * y);
+
+  EXPECT_EQ(0, gcd(big_integer(0), big_integer(0)));
+  EXPECT_EQ(7, gcd(big_integer(0), big_integer(-7)));
+  EXPECT_EQ(6, gcd(big_integer(-12), big_integer(18)));
+  EXPECT_EQ(6, extended_gcd(12, -18, x, y));
+  EXPECT_EQ(6, 12 * x - 18 * y);
+  EXPECT_EQ(5, extended_gcd(5, 5, x, y));
+  EXPECT_EQ(0, x);
+  EXPECT_EQ(1, y);
+  EXPECT_EQ(4, mod_inverse(3, 11));
+  EXPECT_EQ(7, mod_inverse(-3, 11));
+  big_integer p("170141183460469231731687303715884105727"); // 2^127 - 1
+  big_integer a = f1 % p;
+  EXPECT_EQ(1, a * mod_inverse(a, p) % p);
+  EXPECT_THROW(mod_inverse(6, 9), std::domain_error);
+  EXPECT_THROW(mod_inverse(5, 0), std::domain_error);
+}
+
+TEST(correctness_random, roots) {
+  unsigned degrees[] = {2, 3, 5, 17, 100, 5000};
+  std::default_random_engine rng(34);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a;
+    a.random(max_size << (itn % 4), rng);
+    big_integer A(to_string(a));
+    if (A < 0)
+      A = -A;
+    for (unsigned k : degrees) {
+      big_integer r = iroot(A, k);
+      big_integer lo = 1, hi = 1;
+      for (unsigned i = 0; i < k; i++) {
+        lo *= r;
+        hi *= r + 1;
+      }
+      EXPECT_LE(lo, A);
+      EXPECT_GT(hi, A);
+    }
+    big_integer s = isqrt(A);
+    EXPECT_TRUE(is_perfect_square(s * s));
+    EXPECT_EQ(s, isqrt(s * s));
+    EXPECT_EQ(s, isqrt((s + 1) * (s + 1) - 1));
+    EXPECT_FALSE(is_perfect_square(s * s + 1));
+    EXPECT_EQ(-s, iroot(-s * s * s, 3));
+  }
+}
+
+TEST(correctness, perfect_powers) {
+  EXPECT_EQ(0, isqrt(0));
+  EXPECT_EQ(1, isqrt(3));
+  EXPECT_EQ(2, isqrt(4));
+  EXPECT_EQ(big_integer("4294967295"), isqrt(big_integer("18446744073709551615")));
+  EXPECT_EQ(big_integer("4294967296"), isqrt(big_integer("18446744073709551616")));
+  EXPECT_EQ(-3, iroot(-27, 3));
+  EXPECT_EQ(-3, iroot(-28, 3));
+  EXPECT_EQ(7, iroot(7, 1));
+  EXPECT_THROW(isqrt(-1), std::domain_error);
+  EXPECT_THROW(iroot(-16, 4), std::domain_error);
+
+  EXPECT_TRUE(is_perfect_square(0));
+  EXPECT_TRUE(is_perfect_square(1));
+  EXPECT_FALSE(is_perfect_square(2));
+  EXPECT_FALSE(is_perfect_square(-4));
+  int powers[] = {0, 1, -1, 4, 8, 9, -8, 1024, -32768, 1000000, 3 * 3 * 3 * 3 * 3 * 3 * 3};
+  for (int x : powers)
+    EXPECT_TRUE(is_perfect_power(x)) << x;
+  int non_powers[] = {2, -4, -16, 12, 72, 1000001, 2147483647};
+  for (int x : non_powers)
+    EXPECT_FALSE(is_perfect_power(x)) << x;
+
+  big_integer b("123456789123456789");
+  big_integer p = 1;
+  for (int i = 0; i < 13; i++)
+    p *= b;
+  EXPECT_TRUE(is_perfect_power(p));
+  EXPECT_TRUE(is_perfect_power(-p));
+  EXPECT_FALSE(is_perfect_power(p + 1));
+  EXPECT_FALSE(is_perfect_power(p * 2));
+  EXPECT_TRUE(is_perfect_power(p * p * b * b));
+}
+
+TEST(correctness_random, pow) {
+  std::string bases[] = {"3", "-3", "2", "-2", "1024", "12", "-1", "0", "4294967295", "18446744073709551616",
+                         "123456789012345678901234567890"};
+  uint64_t exps[] = {0, 1, 2, 3, 7, 31, 32, 100, 257, 1000};
+  for (auto const& bs : bases) {
+    for (uint64_t e : exps) {
+      big_integer b(bs);
+      big_integer expected = 1;
+      for (uint64_t i = 0; i < e; i++)
+        expected *= b;
+      EXPECT_EQ(expected, pow(b, e)) << bs << "^" << e;
+    }
+  }
+  EXPECT_EQ(big_integer(1) << 100000, pow(big_integer(2), 100000));
+  EXPECT_EQ(-(big_integer(1) << 99999), pow(big_integer(-2), 99999));
+  std::default_random_engine rng(35);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a;
+    a.random(max_size / 64 * (itn + 1), rng);
+    big_integer A(to_string(a));
+    EXPECT_EQ(to_string(a * a), to_string(A * A));
+    EXPECT_EQ(to_string(a * a * a * a * a), to_string(pow(A, 5)));
+    EXPECT_EQ(A * A * A * A * A * A * A * A * A * A * A * A * A, pow(A, 13));
+  }
+}
+
+TEST(correctness, combinatorics) {
+  big_integer f = 1;
+  for (unsigned n = 0; n <= 300; n++) {
+    if (n > 0)
+      f *= n;
+    EXPECT_EQ(f, factorial(n)) << n;
+  }
+  for (unsigned n = 301; n <= 3000; n++)
+    f *= n;
+  EXPECT_EQ(f, factorial(3000));
+
+  std::vector<big_integer> row(1, 1);
+  for (unsigned n = 1; n <= 200; n++) {
+    std::vector<big_integer> next(n + 1, 1);
+    for (unsigned k = 1; k < n; k++)
+      next[k] = row[k - 1] + row[k];
+    row = next;
+    for (unsigned k = 0; k <= n; k += 7)
+      EXPECT_EQ(row[k], binomial(n, k)) << n << " " << k;
+  }
+  EXPECT_EQ(0, binomial(3, 4));
+  EXPECT_EQ(1, binomial(0, 0));
+  EXPECT_EQ(factorial(5000) / (factorial(1234) * factorial(3766)), binomial(5000, 1234));
+
+  EXPECT_EQ(1, primorial(1));
+  EXPECT_EQ(2, primorial(2));
+  EXPECT_EQ(30, primorial(6));
+  EXPECT_EQ(big_integer("614889782588491410"), primorial(50));
+}
+
+TEST(correctness, product_randomized) {
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    std::vector<big_integer> factors;
+    big_integer expected = 1;
+    for (size_t i = 0; i != number_of_multipliers * itn / 4; ++i) {
+      factors.push_back(i % 3 ? rand_big(i % 10) : -rand_big(i % 10));
+      expected *= factors.back();
+    }
+    EXPECT_EQ(expected, product(factors.begin(), factors.end()));
+  }
+}
+
+TEST(correctness, probable_prime_special) {
+  std::vector<bool> sieve(100000, true);
+  sieve[0] = sieve[1] = false;
+  for (size_t i = 2; i < sieve.size(); i++)
+    for (size_t j = i * i; sieve[i] && j < sieve.size(); j += i)
+      sieve[j] = false;
+  int expected_next = 2;
+  for (int n = 0; n < static_cast<int>(sieve.size()) - 100; n++) {
+    EXPECT_EQ(sieve[n], is_probable_prime(n)) << n;
+    if (n == expected_next)
+      for (expected_next++; !sieve[expected_next]; expected_next++) {
+      }
+    EXPECT_EQ(expected_next, next_prime(n)) << n;
+  }
+  EXPECT_FALSE(is_probable_prime(-7));
+  // Carmichael numbers, strong pseudoprimes to base 2 and to bases 2, 3, 5, 7,
+  // and strong Lucas pseudoprimes
+  int composites[] = {561, 41041, 2047, 3277, 4033, 5459, 5777, 10877, 999999999};
+  for (int c : composites)
+    EXPECT_FALSE(is_probable_prime(c)) << c;
+  EXPECT_FALSE(is_probable_prime(big_integer("3215031751")));
+  EXPECT_FALSE(is_probable_prime(big_integer("3825123056546413051")));
+  EXPECT_FALSE(is_probable_prime(big_integer("318665857834031151167461")));
+  EXPECT_TRUE(is_probable_prime(big_integer("18446744073709551557")));
+
+  big_integer m521 = (big_integer(1) << 521) - 1;
+  EXPECT_TRUE(is_probable_prime(m521, 5));
+  EXPECT_FALSE(is_probable_prime((big_integer(1) << 523) - 1));
+  EXPECT_FALSE(is_probable_prime(m521 * ((big_integer(1) << 607) - 1)));
+  EXPECT_FALSE(is_probable_prime(m521 * m521));
+  EXPECT_EQ(m521, next_prime(m521 - 2));
+}
+
+TEST(correctness_random, probable_prime) {
+  // half of the candidates are shifted to the next prime so both answers occur
+  size_t sizes[] = {40, 64, 100, 512, 1024, 2048};
+  std::default_random_engine rng(37);
+  std::vector<big_integer> candidates;
+  std::vector<bool> expected;
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    for (size_t sz : sizes) {
+      if (sz > 512 && itn % 8 != 0)
+        continue;
+      big_integer_gmp a;
+      a.random(sz, rng);
+      big_integer A(to_string(a));
+      EXPECT_EQ(probab_prime(a, 25) != 0, is_probable_prime(A, 2)) << A;
+      if (A > 0 && itn % 2 == 0) {
+        big_integer P = next_prime(A);
+        EXPECT_NE(0, probab_prime(big_integer_gmp(to_string(P)), 25)) << A;
+        if (sz <= 512) {
+          for (big_integer c = A + 1; c < P; c += 1)
+            EXPECT_EQ(0, probab_prime(big_integer_gmp(to_string(c)), 25)) << c;
+        }
+        A = P;
+      }
+      candidates.push_back(A);
+      expected.push_back(is_probable_prime(A));
+    }
+  }
+  EXPECT_EQ(expected, is_probable_prime(candidates, 0, 4));
+  EXPECT_EQ(expected, is_probable_prime(candidates, 0, 1));
+}
+
+TEST(correctness_random, random_bits) {
+  std::mt19937_64 rng(38);
+  size_t sizes[] = {0, 1, 31, 32, 33, 64, 65, 1000, 4096};
+  for (size_t bits : sizes) {
+    size_t top_set = 0;
+    for (size_t itn = 0; itn != 200; ++itn) {
+      big_integer x = big_integer::random_bits(bits, rng);
+      EXPECT_GE(x, 0);
+      if (bits == 0) {
+        EXPECT_EQ(0, x);
+        continue;
+      }
+      EXPECT_LT(x, big_integer(1) << static_cast<int>(bits));
+      if (x >= big_integer(1) << static_cast<int>(bits - 1))
+        top_set++;
+    }
+    if (bits > 0) {
+      EXPECT_GT(top_set, 50u) << bits;
+      EXPECT_LT(top_set, 150u) << bits;
+    }
+  }
+
+  std::vector<int> hits(6);
+  for (size_t itn = 0; itn != 600; ++itn)
+    hits[static_cast<int>(to_string(big_integer::random_below(6, rng))[0] - '0')]++;
+  for (int h : hits)
+    EXPECT_GT(h, 50);
+  EXPECT_EQ(0, big_integer::random_below(1, rng));
+  big_integer bound = (big_integer(1) << 3000) + 1;
+  for (size_t itn = 0; itn != 100; ++itn) {
+    big_integer x = big_integer::random_below(bound, rng);
+    EXPECT_GE(x, 0);
+    EXPECT_LT(x, bound);
+  }
+  EXPECT_THROW(big_integer::random_below(0, rng), std::domain_error);
+  EXPECT_THROW(big_integer::random_below(-5, rng), std::domain_error);
+}
+
+TEST(correctness, native_conversions) {
+  EXPECT_EQ(big_integer("9223372036854775807"), big_integer(std::numeric_limits<int64_t>::max()));
+  EXPECT_EQ(big_integer("-9223372036854775808"), big_integer(std::numeric_limits<int64_t>::min()));
+  EXPECT_EQ(big_integer("18446744073709551615"), big_integer(std::numeric_limits<uint64_t>::max()));
+  EXPECT_EQ(big_integer("4294967295"), big_integer(std::numeric_limits<unsigned>::max()));
+  EXPECT_EQ(big_integer("-9223372036854775808"), big_integer(std::numeric_limits<long long>::min()));
+  __extension__ typedef __int128 i128;
+  __extension__ typedef unsigned __int128 u128;
+  EXPECT_EQ(big_integer("340282366920938463463374607431768211455"), big_integer(~static_cast<u128>(0)));
+  EXPECT_EQ(big_integer("-170141183460469231731687303715884105728"), big_integer(static_cast<i128>(static_cast<u128>(1) << 127)));
+  EXPECT_EQ(big_integer("-1"), big_integer(static_cast<i128>(-1)));
+
+  EXPECT_EQ(std::numeric_limits<int64_t>::min(), to_int64(big_integer("-9223372036854775808")));
+  EXPECT_EQ(-5, to_int64(-5));
+  EXPECT_EQ(std::numeric_limits<uint64_t>::max(), to_uint64(big_integer("18446744073709551615")));
+  EXPECT_EQ(0u, to_uint64(0));
+  EXPECT_THROW(to_int64(big_integer("9223372036854775808")), std::out_of_range);
+  EXPECT_THROW(to_int64(big_integer("-9223372036854775809")), std::out_of_range);
+  EXPECT_THROW(to_uint64(big_integer("18446744073709551616")), std::out_of_range);
+  EXPECT_THROW(to_uint64(-1), std::out_of_range);
+
+  EXPECT_EQ(big_integer("100000000000000000000"), big_integer(1e20));
+  EXPECT_EQ(-2, big_integer(-2.75));
+  EXPECT_EQ(0, big_integer(-0.5));
+  EXPECT_EQ(big_integer(1) << 1000, big_integer(std::ldexp(1.0, 1000)));
+  EXPECT_THROW(big_integer(std::numeric_limits<double>::infinity()), std::domain_error);
+  EXPECT_THROW(big_integer(std::nan("")), std::domain_error);
+
+  // 2^53 + 1 is a tie between two doubles and rounds to the even one
+  EXPECT_EQ(std::ldexp(1.0, 63), to_double(((big_integer(1) << 53) + 1) << 10));
+  EXPECT_EQ(std::ldexp(1.0, 63) + std::ldexp(2.0, 11), to_double(((big_integer(1) << 53) + 3) << 10));
+  // a set bit far below the tie decides it upwards
+  EXPECT_EQ(std::ldexp(1.0, 153), to_double(((big_integer(1) << 53) + 1) << 100));
+  EXPECT_EQ(std::ldexp(1.0, 153) + std::ldexp(1.0, 101), to_double((((big_integer(1) << 53) + 1) << 100) + 1));
+  EXPECT_EQ(std::numeric_limits<double>::infinity(), to_double(big_integer(1) << 1024));
+  EXPECT_EQ(-std::numeric_limits<double>::infinity(), to_double(-(big_integer(1) << 1100)));
+}
+
+TEST(correctness_random, to_double) {
+  // strtod rounds decimal input correctly, so it serves as the reference
+  std::mt19937_64 rng(39);
+  for (size_t itn = 0; itn != 2000; ++itn) {
+    size_t bits = rng() % 1100;
+    big_integer x = big_integer::random_bits(bits, rng);
+    if (itn % 3 == 0)
+      x = ((x >> 80) << 80) + (big_integer(1) << 26);
+    if (itn % 2)
+      x = -x;
+    std::string s = to_string(x);
+    EXPECT_EQ(std::strtod(s.c_str(), nullptr), to_double(x)) << s;
+    if (bits <= 63) {
+      EXPECT_EQ(x, big_integer(to_int64(x)));
+    }
+    if (bits <= 53) {
+      EXPECT_EQ(x, big_integer(to_double(x)));
+    }
+  }
+}
+
+TEST(correctness_random, small_values) {
+  // operands of up to two limbs take the native 64/128-bit path
+  __extension__ typedef __int128 i128;
+  __extension__ typedef unsigned __int128 u128;
+  std::mt19937_64 rng(40);
+  for (size_t itn = 0; itn != 20000; ++itn) {
+    uint64_t x = rng() >> (rng() % 64);
+    uint64_t y = rng() >> (rng() % 64);
+    if (itn % 7 == 0)
+      x = std::numeric_limits<uint64_t>::max();
+    i128 a = itn % 2 ? -static_cast<i128>(x) : static_cast<i128>(x);
+    i128 b = itn % 3 ? -static_cast<i128>(y) : static_cast<i128>(y);
+    big_integer A(a), B(b);
+    EXPECT_EQ(big_integer(a + b), A + B);
+    EXPECT_EQ(big_integer(a - b), A - B);
+    big_integer prod(static_cast<u128>(x) * y);
+    EXPECT_EQ((a < 0) != (b < 0) ? -prod : prod, A * B);
+    if (b != 0) {
+      EXPECT_EQ(big_integer(a / b), A / B);
+      EXPECT_EQ(big_integer(a % b), A % B);
+    }
+    EXPECT_EQ(a < b, A < B);
+    // one long operand falls back to the limb code
+    big_integer C = (A << 100) + B;
+    EXPECT_EQ(C - (A << 100), B);
+    EXPECT_EQ((C + A) - C, A);
+  }
+  EXPECT_EQ(big_integer("340282366920938463426481119284349108225"),
+            big_integer(std::numeric_limits<uint64_t>::max()) * big_integer(std::numeric_limits<uint64_t>::max()));
+  EXPECT_EQ(big_integer("-36893488147419103230"),
+            -big_integer(std::numeric_limits<uint64_t>::max()) - big_integer(std::numeric_limits<uint64_t>::max()));
+}
+
+TEST(correctness, move_semantics) {
+  static_assert(std::is_nothrow_move_constructible<big_integer>::value, "move constructor must be noexcept");
+  static_assert(std::is_nothrow_move_assignable<big_integer>::value, "move assignment must be noexcept");
+  big_integer a = big_integer(1) << 200;
+  big_integer b = std::move(a);
+  EXPECT_EQ(0, a);
+  EXPECT_EQ(big_integer(1) << 200, b);
+  a = -7;
+  swap(a, b);
+  EXPECT_EQ(-7, b);
+  EXPECT_EQ(big_integer(1) << 200, a);
+  big_integer& alias = a;
+  a = alias;
+  EXPECT_EQ(big_integer(1) << 200, a);
+  a += 1;
+  EXPECT_EQ((big_integer(1) << 200) + 1, a);
+}
+
+TEST(correctness_random, rvalue_operators) {
+  std::mt19937_64 rng(41);
+  for (size_t itn = 0; itn != 2000; ++itn) {
+    big_integer a = big_integer::random_bits(rng() % 300, rng);
+    big_integer b = big_integer::random_bits(rng() % 300, rng);
+    big_integer c = big_integer::random_bits(rng() % 300, rng);
+    if (itn % 2)
+      a = -a;
+    if (itn % 3)
+      b = -b;
+    big_integer sum = a;
+    sum += b;
+    big_integer diff = a;
+    diff -= b;
+    EXPECT_EQ(sum, a + big_integer(b));
+    EXPECT_EQ(sum, big_integer(a) + big_integer(b));
+    EXPECT_EQ(sum, big_integer(a) + b);
+    EXPECT_EQ(diff, a - big_integer(b));
+    EXPECT_EQ(diff, big_integer(a) - big_integer(b));
+    EXPECT_EQ(diff, big_integer(a) - b);
+    big_integer expected = a * b;
+    expected += c * c;
+    expected -= a;
+    EXPECT_EQ(expected, a * b + c * c - a);
+    EXPECT_EQ(-expected, a - (a * b + c * c));
+  }
+}
+
+TEST(correctness, rvalue_operand_choice) {
+  auto allocations = [] {
+    pool_stats s = pool_statistics();
+    return s.hits + s.misses;
+  };
+  // long: its buffer is full, the carry would reallocate it
+  big_integer long_ones = (big_integer(1) << 1920) - 1;
+  long_ones.shrink_to_fit();
+  ASSERT_LT(long_ones.capacity(), 61u);
+  // short: fewer limbs, but room for the whole result
+  big_integer roomy;
+  roomy.reserve(100);
+  roomy += (big_integer(1) << 90) + 1;
+
+  big_integer l = long_ones;
+  l.shrink_to_fit();
+  big_integer r = roomy;
+  r.reserve(100);
+  uint64_t before = allocations();
+  big_integer sum = std::move(l) + std::move(r);
+  EXPECT_EQ(before, allocations());
+  EXPECT_EQ(long_ones + roomy, sum);
+
+  l = long_ones;
+  l.shrink_to_fit();
+  r = roomy;
+  r.reserve(100);
+  before = allocations();
+  big_integer diff = std::move(l) - std::move(r);
+  EXPECT_EQ(before, allocations());
+  EXPECT_EQ(long_ones - roomy, diff);
+
+  // a shared temporary would be copied on write; the unique one is taken
+  big_integer big = (big_integer(1) << 1000) + 3;
+  big_integer shared = big;
+  r = roomy;
+  r.reserve(100);
+  before = allocations();
+  sum = std::move(shared) + std::move(r);
+  EXPECT_EQ(before, allocations());
+  EXPECT_EQ(big + roomy, sum);
+}
+
+TEST(correctness, shared_buffer_writes) {
+  // writes and trims through a copy must not reach the buffer it was copied from
+  big_integer x = (big_integer(1) << 640) + 5;
+  big_integer y = x;
+  y -= big_integer(1) << 640;
+  EXPECT_EQ(5, y);
+  EXPECT_EQ((big_integer(1) << 640) + 5, x);
+  big_integer z = x;
+  z += x;
+  EXPECT_EQ((big_integer(1) << 641) + 10, z);
+  z = x;
+  z >>= 600;
+  EXPECT_EQ(big_integer(1) << 40, z);
+  z = x;
+  z &= 7;
+  EXPECT_EQ(5, z);
+  EXPECT_EQ((big_integer(1) << 640) + 5, x);
+}
+
+TEST(correctness, shared_prefix) {
+  // a copy trimmed without copying shares the buffer, not the value
+  big_integer::cont a;
+  for (u32 i = 1; i <= 5; i++)
+    a.push_back(i);
+  big_integer::cont b = a;
+  EXPECT_TRUE(a.shares(b));
+  b.truncate(3);
+  EXPECT_FALSE(a.shares(b));
+  EXPECT_EQ(3u, b.size());
+  EXPECT_EQ(5u, a.size());
+  b.resize(5);
+  EXPECT_FALSE(a == b);
+  EXPECT_EQ(5u, a[4]);
+}
+
+TEST(correctness, inline_limit) {
+  // values cross the two-limb inline limit in both directions
+  big_integer max64 = std::numeric_limits<uint64_t>::max();
+  big_integer x = max64;
+  x += 1;
+  EXPECT_EQ(big_integer(1) << 64, x);
+  EXPECT_EQ("18446744073709551616", to_string(x));
+  x -= 1;
+  EXPECT_EQ(max64, x);
+  big_integer y = x;
+  y <<= 1;
+  y >>= 1;
+  EXPECT_EQ(max64, y);
+  y = (big_integer(1) << 200) + 3;
+  y %= big_integer(1) << 64;
+  EXPECT_EQ(3, y);
+  EXPECT_EQ(-max64 - 1, big_integer(-1) << 64);
+  EXPECT_EQ(max64, ~-(big_integer(1) << 64));
+}
+
+TEST(correctness, compact_layout) {
+  static_assert(sizeof(big_integer) <= 16, "big_integer must fit in 16 bytes");
+  // the sign shares a word with the size, so it must travel with every copy, move and swap
+  std::vector<big_integer> v = {-(big_integer(1) << 300), -5, 7, big_integer(1) << 300};
+  std::vector<big_integer> copies = v;
+  big_integer moved = std::move(copies[0]);
+  swap(copies[1], copies[3]);
+  EXPECT_EQ(v[0], moved);
+  EXPECT_EQ(v[3], copies[1]);
+  EXPECT_EQ(v[1], copies[3]);
+  copies[2] = v[0];
+  EXPECT_EQ(v[0], copies[2]);
+  copies[2] = v[1];
+  EXPECT_EQ(-5, copies[2]);
+  EXPECT_TRUE(v[0] < v[1] && v[1] < v[2] && v[2] < v[3]);
+}
+
+TEST(correctness, tagged_inline_limit) {
+  static_assert(sizeof(tagged_integer) == 8, "tagged_integer must be one word");
+  int64_t limit = int64_t(1) << 62;
+  tagged_integer x = limit - 1;
+  EXPECT_TRUE(x.is_inline());
+  x += 1;
+  EXPECT_FALSE(x.is_inline());
+  EXPECT_EQ(big_integer(1) << 62, x.to_big_integer());
+  x -= 1;
+  EXPECT_TRUE(x.is_inline());
+  EXPECT_EQ(tagged_integer(limit - 1), x);
+  EXPECT_FALSE(tagged_integer(-limit).is_inline());
+  EXPECT_TRUE(tagged_integer(-limit + 1).is_inline());
+  EXPECT_EQ(tagged_integer(std::numeric_limits<int64_t>::min()).to_big_integer(),
+            big_integer(std::numeric_limits<int64_t>::min()));
+  tagged_integer big = tagged_integer(big_integer(1) << 200);
+  EXPECT_FALSE(big.is_inline());
+  EXPECT_TRUE((big / big).is_inline());
+  EXPECT_TRUE(tagged_integer(-5) < big && -big < tagged_integer(-5) && -big < big);
+  EXPECT_EQ("1606938044258990275541962092341162602522202993782792835301376", to_string(big));
+  std::unordered_set<tagged_integer> set = {tagged_integer(3), big, tagged_integer(-7)};
+  EXPECT_EQ(1u, set.count(tagged_integer(big_integer(1) << 200)));
+  EXPECT_EQ(1u, set.count(tagged_integer(1) + tagged_integer(2)));
+  EXPECT_EQ(0u, set.count(tagged_integer(7)));
+}
+
+TEST(correctness, tagged_shares_limb_buffer) {
+  auto allocations = [] {
+    pool_stats s = pool_statistics();
+    return s.hits + s.misses;
+  };
+  big_integer value = (big_integer(1) << 300) + 12345;
+  uint64_t before = allocations();
+  tagged_integer big(value);
+  // the promoted value gets one exact-size buffer of its own
+  EXPECT_EQ(before + 1, allocations());
+  before = allocations();
+  tagged_integer copy = big;
+  tagged_integer negated = -big;
+  big_integer view = big.to_big_integer();
+  tagged_integer back(view);
+  EXPECT_EQ(before, allocations());
+  EXPECT_EQ(value, view);
+  EXPECT_EQ(-value, negated.to_big_integer());
+  EXPECT_EQ(big, back);
+  EXPECT_NE(big, negated);
+  EXPECT_TRUE(negated < big);
+  // a view must not be written through: the shared buffer is copied first
+  view += 1;
+  EXPECT_EQ(value, copy.to_big_integer());
+  // results leaving and returning to the heap stay canonical
+  big += copy;
+  EXPECT_EQ(value * 2, big.to_big_integer());
+  big -= copy;
+  EXPECT_EQ(copy, big);
+  big -= copy;
+  EXPECT_TRUE(big.is_inline());
+  EXPECT_EQ(tagged_integer(0), big);
+}
+
+TEST(correctness_random, tagged_arithmetic) {
+  std::mt19937_64 rng(47);
+  for (size_t itn = 0; itn != 20000; ++itn) {
+    // mostly inline values, with operands and results crossing 2^62 either way
+    int64_t a = static_cast<int64_t>(rng()) >> (rng() % 64);
+    int64_t b = static_cast<int64_t>(rng()) >> (rng() % 64);
+    tagged_integer ta = a, tb = b;
+    big_integer ba = a, bb = b;
+    EXPECT_EQ(ba + bb, (ta + tb).to_big_integer());
+    EXPECT_EQ(ba - bb, (ta - tb).to_big_integer());
+    EXPECT_EQ(ba * bb, (ta * tb).to_big_integer());
+    EXPECT_EQ(ba * bb * bb, (ta * tb * tb).to_big_integer());
+    if (b != 0) {
+      EXPECT_EQ(ba / bb, (ta / tb).to_big_integer());
+      EXPECT_EQ(ba % bb, (ta % tb).to_big_integer());
+      EXPECT_EQ(ba * ba / bb, (ta * ta / tb).to_big_integer());
+    }
+    EXPECT_EQ(ba < bb, ta < tb);
+    EXPECT_EQ(ba == bb, ta == tb);
+    EXPECT_EQ(to_string(ba * bb), to_string(ta * tb));
+    big_integer limit = big_integer(1) << 62;
+    EXPECT_EQ(-limit < ba * bb && ba * bb < limit, (ta * tb).is_inline());
+  }
+}
+
+TEST(correctness, limb_pool) {
+  pool_trim();
+  pool_stats before = pool_statistics();
+  EXPECT_EQ(0u, before.retained);
+  void* p = pool_allocate(100);
+  pool_deallocate(p, 100);
+  EXPECT_EQ(pool_block_size(100), pool_statistics().retained);
+  // any size of the same class reuses the block
+  EXPECT_EQ(p, pool_allocate(pool_block_size(100)));
+  EXPECT_EQ(before.hits + 1, pool_statistics().hits);
+  pool_deallocate(p, 100);
+
+  std::vector<uint32_t, pool_allocator<uint32_t>> v(1000, 7);
+  v.resize(5000, 7);
+  EXPECT_EQ(5000 * 7u, std::accumulate(v.begin(), v.end(), 0u));
+
+  size_t limit = pool_limit();
+  set_pool_limit(0);
+  pool_trim();
+  {
+    big_integer x = (big_integer(1) << 1000) * 3;
+  }
+  EXPECT_EQ(0u, pool_statistics().retained);
+  set_pool_limit(limit);
+  uint64_t hits = pool_statistics().hits;
+  for (int i = 0; i < 10; i++) {
+    big_integer x = (big_integer(1) << 1000) * 3;
+    EXPECT_EQ(big_integer(3) << 1000, x);
+  }
+  EXPECT_LT(hits, pool_statistics().hits);
+  pool_trim();
+
+  // the limit covers all threads: with this thread's lists full, a block
+  // freed in another thread goes straight to the heap
+  set_pool_limit(pool_retained() + pool_block_size(100));
+  pool_deallocate(pool_allocate(100), 100);
+  EXPECT_EQ(pool_block_size(100), pool_statistics().retained);
+  std::thread([] {
+    pool_deallocate(pool_allocate(100), 100);
+    EXPECT_EQ(0u, pool_statistics().retained);
+  }).join();
+  set_pool_limit(limit);
+  pool_trim();
+}
+
+TEST(correctness, scratch_marks) {
+  u32* first;
+  {
+    scratch_mark outer;
+    first = outer.alloc(100);
+    u32* second = outer.alloc(96);
+    // sizes are rounded up to a cache line
+    EXPECT_EQ(first + 112, second);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(second) % 64);
+    {
+      scratch_mark inner;
+      u32* third = inner.alloc(SCRATCH_CHUNK);
+      // may spill into another chunk; earlier allocations keep their contents
+      std::fill(third, third + SCRATCH_CHUNK, 7u);
+      std::fill(first, first + 100, 1u);
+      EXPECT_EQ(7u, third[SCRATCH_CHUNK - 1]);
+      u32* huge = inner.alloc(SCRATCH_HEAP_LIMIT + 1);
+      huge[SCRATCH_HEAP_LIMIT] = 5;
+      EXPECT_EQ(5u, huge[SCRATCH_HEAP_LIMIT]);
+    }
+    // released in LIFO order: the next allocation reuses the inner space
+    scratch_mark again;
+    EXPECT_EQ(second + 96, again.alloc(10));
+  }
+  scratch_mark last;
+  EXPECT_EQ(first, last.alloc(1));
+  EXPECT_GE(scratch_capacity(), SCRATCH_CHUNK + 200);
+}
+
+TEST(correctness, capacity_control) {
+  auto allocations = [] {
+    pool_stats s = pool_statistics();
+    return s.hits + s.misses;
+  };
+  big_integer x = (big_integer(1) << 1000) - 1;
+  big_integer x1000 = x * 1000;
+  big_integer sum;
+  EXPECT_EQ(2u, sum.capacity());
+  sum.reserve(64);
+  EXPECT_GE(sum.capacity(), 64u);
+
+  // a reserved accumulator never allocates, even through small values
+  uint64_t before = allocations();
+  for (int i = 0; i < 1000; i++) {
+    sum += x;
+  }
+  sum -= x1000;
+  sum += 5;
+  sum -= -7;
+  sum *= x;
+  sum <<= 3;
+  sum >>= 1000;
+  sum /= 3;
+  sum %= x;
+  EXPECT_EQ(before, allocations());
+  EXPECT_EQ(((big_integer(12) * x) << 3 >> 1000) / 3 % x, sum);
+  EXPECT_GE(sum.capacity(), 64u);
+
+  // an accumulator without reserve settles after its first growth
+  big_integer acc;
+  for (int i = 0; i < 100; i++) {
+    acc += x;
+  }
+  before = allocations();
+  for (int i = 0; i < 1000; i++) {
+    acc += x;
+  }
+  EXPECT_EQ(before, allocations());
+  EXPECT_EQ(x * 1100, acc);
+
+  // shrinking keeps the value
+  big_integer big = (big_integer(1) << 5000) + 1;
+  big >>= 4000;
+  size_t wide = big.capacity();
+  big.shrink_to_fit();
+  EXPECT_LT(big.capacity(), wide);
+  EXPECT_EQ((big_integer(1) << 1000), big);
+  big -= big - 3;
+  big.shrink_to_fit();
+  EXPECT_EQ(2u, big.capacity());
+  EXPECT_EQ(3, big);
+
+  // a shared buffer is not written through
+  big_integer a = x;
+  a.reserve(100);
+  big_integer b = a;
+  b += 1;
+  b <<= 1;
+  EXPECT_EQ(x, a);
+  EXPECT_EQ((x + 1) << 1, b);
+
+  // a shared product lands in an owned buffer that keeps the old capacity
+  size_t reserved = a.capacity();
+  big_integer c = a;
+  a *= 3;
+  EXPECT_EQ(x, c);
+  EXPECT_EQ(x * 3, a);
+  EXPECT_GE(a.capacity(), reserved);
+
+  // bitwise results and negative shifts are written back into the buffer
+  big_integer bits = -x;
+  bits.reserve(100);
+  bits &= x << 5;
+  bits |= -(x >> 7);
+  bits ^= x;
+  bits >>= 100;
+  EXPECT_GE(bits.capacity(), 100u);
+  EXPECT_EQ((((-x & (x << 5)) | -(x >> 7)) ^ x) >> 100, bits);
+  EXPECT_LT(bits, 0);
+}
+
+#ifdef BIGINT_ATOMIC_REFCOUNT
+TEST(correctness, shared_across_threads) {
+  // copies of one buffer are taken, modified and dropped on several threads at once
+  big_integer shared = (big_integer(1) << 5000) + 12345;
+  std::vector<std::thread> threads;
+  std::vector<char> ok(4);
+  for (int t = 0; t < 4; t++)
+    threads.emplace_back([&, t] {
+      bool good = true;
+      for (int i = 0; i < 2000; i++) {
+        big_integer copy = shared;
+        copy += t;
+        good = good && copy - t == shared;
+      }
+      ok[t] = good;
+    });
+  for (auto& t : threads)
+    t.join();
+  for (char good : ok)
+    EXPECT_TRUE(good);
+  EXPECT_EQ((big_integer(1) << 5000) + 12345, shared);
+}
+#endif
+
+namespace {
+// restores the process-wide kernel tier on scope exit, also when a test throws
+struct tier_guard {
+  kernel_tier saved = kernels().tier;
+  ~tier_guard() {
+    set_kernel_tier(saved);
+  }
+};
+
+// runs f once under every kernel tier this CPU supports
+template<typename F>
+void for_each_supported_tier(F&& f) {
+  tier_guard guard;
+  for (kernel_tier tier : {kernel_tier::generic, kernel_tier::bmi2, kernel_tier::avx2, kernel_tier::avx512}) {
+    if (!set_kernel_tier(tier))
+      continue;
+    SCOPED_TRACE(kernel_tier_name(tier));
+    f();
+  }
+}
+}
+
+TEST(correctness_random, kernel_tiers) {
+  for_each_supported_tier([&] {
+    std::default_random_engine rng(42);
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+      big_integer_gmp a, b;
+      a.random(max_size, rng);
+      b.random(max_size / 3, rng);
+      int shift = myrand() % max_size;
+      big_integer A = big_integer(to_string(a));
+      big_integer B = big_integer(to_string(b));
+      EXPECT_EQ(to_string(a + b), to_string(A + B));
+      EXPECT_EQ(to_string(b - a), to_string(B - A));
+      EXPECT_EQ(to_string(a * b), to_string(A * B));
+      EXPECT_EQ(to_string(a << shift), to_string(A << shift));
+      EXPECT_EQ(to_string(a >> shift), to_string(A >> shift));
+    }
+  });
+}
+
+TEST(correctness_random, mul_basecase_shapes) {
+  size_t sizes[] = {1, 2, 3, 4, 5, 7, 8, 9, 13, 16, 17, 31, 64, 65, 200};
+  for_each_supported_tier([&] {
+    std::default_random_engine rng(7);
+    for (size_t n : sizes) {
+      for (size_t m : sizes) {
+        // all limbs are 0xFFFFFFFF: longest carry chains
+        big_integer_gmp ga = (big_integer_gmp(1) << (32 * n)) - 1;
+        big_integer_gmp gb = (big_integer_gmp(1) << (32 * m)) - 1;
+        big_integer a = (big_integer(1) << (32 * n)) - 1;
+        big_integer b = (big_integer(1) << (32 * m)) - 1;
+        EXPECT_EQ(to_string(ga * gb), to_string(a * b));
+
+        ga.random(32 * n, rng);
+        gb.random(32 * m, rng);
+        EXPECT_EQ(to_string(ga * gb), to_string(big_integer(to_string(ga)) * big_integer(to_string(gb))));
+      }
+    }
+  });
+}
+
+TEST(correctness_random, mul_unbalanced) {
+  size_t shapes[][2] = {{1200, 30}, {1200, 520}, {1100, 600}, {700, 650}};
+  std::default_random_engine rng(28);
+  for (auto const& shape : shapes) {
+    big_integer_gmp a, b;
+    a.random(32 * shape[0], rng);
+    b.random(32 * shape[1], rng);
+    std::string expected = to_string(a * b);
+    big_integer A = big_integer(to_string(a));
+    big_integer B = big_integer(to_string(b));
+    for_each_supported_tier([&] {
+      EXPECT_EQ(expected, to_string(A * B));
+      EXPECT_EQ(expected, to_string(B * A));
+    });
+  }
+}
+
+TEST(correctness_random, parallel_mul) {
+  size_t shapes[][2] = {{2100, 2100}, {3000, 360}};
+  std::default_random_engine rng(29);
+  set_mul_threads(4);
+  for (auto const& shape : shapes) {
+    big_integer_gmp a, b;
+    a.random(32 * shape[0], rng);
+    b.random(32 * shape[1], rng);
+    std::string expected = to_string(a * b);
+    big_integer A = big_integer(to_string(a));
+    big_integer B = big_integer(to_string(b));
+    for (size_t threads = 1; threads <= 4; ++threads)
+      EXPECT_EQ(expected, to_string(parallel_mul(A, B, threads)));
+    EXPECT_EQ(expected, to_string(A * B));
+  }
+  set_mul_threads(1);
+}
+
 // TODO: extend due to idea
 TEST(correctness_twos_complement, simple) {
   std::string a = "-36893488147419103232"; // -(1 << 65)
@@ -4,122 +4,202 @@
 
 #include <algorithm>
 #include "container.h"
-container::container() : is_small(true), empty(true) {
-    data.small = 0;
+container::container() : length(0), is_small(1), positive(1) {
+    data.small[0] = data.small[1] = 0;
 }
 container::~container() {
     if (!is_small)
         data.big->del();
 }
-container::container(container const &other) : is_small(other.is_small), empty(other.empty) {
-    if (is_small)
-        data.small = other.data.small;
-    else
-        data.big = other.data.big->add();
+container::container(container const &other)
+    : length(other.length), is_small(other.is_small), positive(1), data(other.data) {
+    if (!is_small)
+        data.big->add();
+}
+container::container(container &&other) noexcept
+    : length(other.length), is_small(other.is_small), positive(1), data(other.data) {
+    other.length = 0;
+    other.is_small = 1;
 }
 container::container(size_t i) : container() {
     resize(i);
 }
+void container::own(size_t capacity) {
+    limb_buffer *b = data.big;
+    if (b->unique() && b->capacity >= capacity)
+        return;
+    data.big = b->copy(length, capacity);
+    b->del();
+}
+size_t container::grown(size_t n) const {
+    size_t cap = data.big->capacity;
+    return n <= cap ? cap : std::max(n, 2 * cap);
+}
+void container::to_small(size_t n) {
+    limb_buffer *b = data.big;
+    std::copy(b->limbs(), b->limbs() + n, data.small);
+    b->del();
+    is_small = 1;
+    length = n;
+}
 void container::push_back(u32 v) {
-    if (empty) {
-        data.small = v;
-        empty = false;
+    if (is_small && length < INLINE_LIMBS) {
+        data.small[length++] = v;
     } else if (is_small) {
-        auto first = data.small;
-        data.big = new wrapper;
-        data.big->v.push_back(first);
-        data.big->v.push_back(v);
-        is_small = false;
+        limb_buffer *b = limb_buffer::create(2 * INLINE_LIMBS);
+        std::copy(data.small, data.small + INLINE_LIMBS, b->limbs());
+        b->limbs()[INLINE_LIMBS] = v;
+        data.big = b;
+        is_small = 0;
+        length = INLINE_LIMBS + 1;
     } else {
-        data.big = data.big->unshare();
-        data.big->v.push_back(v);
+        own(grown(length + 1));
+        data.big->limbs()[length++] = v;
     }
 }
 void container::pop_back() {
-    // добавь для is_small
-    data.big = data.big->unshare();
-    data.big->v.pop_back();
-    if (data.big->v.size() == 1) {
-        u32 value = data.big->v[0];
-        delete data.big;
-        data.small = value;
-        is_small = true;
-    }
+    truncate(length - 1);
+}
+void container::truncate(size_t n) {
+    if (n >= length)
+        return;
+    // общий буфер не копируется: длина у каждого владельца своя
+    if (!is_small && n <= INLINE_LIMBS && !data.big->unique())
+        to_small(n);
+    else
+        length = n;
 }
 u32 &container::operator[](size_t ind) {
     if (is_small)
-        return data.small;
+        return data.small[ind];
     else {
-        data.big = data.big->unshare();
-        return data.big->v[ind];
+        own(data.big->capacity);
+        return data.big->limbs()[ind];
     }
 }
 u32 const &container::operator[](size_t ind) const {
     if (is_small)
-        return data.small;
+        return data.small[ind];
     else
-        return data.big->v[ind];
+        return data.big->limbs()[ind];
 }
 u32 &container::back() {
     if (is_small)
-        return data.small;
+        return data.small[length == 0 ? 0 : length - 1];
     else {
-        data.big = data.big->unshare();
-        return data.big->v.back();
+        own(data.big->capacity);
+        return data.big->limbs()[length - 1];
     }
 }
-size_t container::size() const {
+u32 *container::mutable_span() {
     if (is_small)
-        return empty ? 0 : 1;
-    else
-        return data.big->v.size();
+        return data.small;
+    own(data.big->capacity);
+    return data.big->limbs();
+}
+u32 const *container::span() const {
+    return is_small ? data.small : data.big->limbs();
+}
+size_t container::size() const {
+    return length;
 }
 void container::resize(size_t sz) {
     resize(sz, 0);
 }
 void container::resize(size_t sz, u32 v) {
-    if (sz == 1){
-        data.small = v;
-        is_small = true;
-    }else {
+    if (sz <= INLINE_LIMBS && (is_small || !data.big->unique())) {
+        size_t n = std::min<size_t>(sz, length);
+        if (!is_small)
+            to_small(n);
+        std::fill(data.small + n, data.small + sz, v);
+    } else {
         if (is_small) {
-            u32 val = data.small;
-            data.big = new wrapper;
-            if (!empty)
-                data.big->v.push_back(val);
+            limb_buffer *b = limb_buffer::create(sz);
+            std::copy(data.small, data.small + length, b->limbs());
+            data.big = b;
+            is_small = 0;
+        } else {
+            own(grown(sz));
         }
-        data.big = data.big->unshare();
-        data.big->v.resize(sz, v);
-        is_small = false;
+        if (sz > length)
+            std::fill(data.big->limbs() + length, data.big->limbs() + sz, v);
     }
-    empty = false;
+    length = sz;
 }
-void container::reverse() {
-    if (!is_small) {
-        data.big = data.big->unshare();
-        std::reverse(data.big->v.begin(), data.big->v.end());
+size_t container::capacity() const {
+    return is_small ? INLINE_LIMBS : data.big->capacity;
+}
+void container::reserve(size_t n) {
+    if (is_small) {
+        if (n <= INLINE_LIMBS)
+            return;
+        limb_buffer *b = limb_buffer::create(n);
+        std::copy(data.small, data.small + length, b->limbs());
+        data.big = b;
+        is_small = 0;
+    } else {
+        own(n);
+    }
+}
+void container::shrink_to_fit() {
+    if (is_small)
+        return;
+    if (length <= INLINE_LIMBS) {
+        to_small(length);
+        return;
     }
+    // общий буфер держат и другие владельцы: своя копия памяти не освободит
+    limb_buffer *b = data.big;
+    if (!b->unique() || pool_block_size(sizeof(limb_buffer) + length * sizeof(u32)) >=
+                        sizeof(limb_buffer) + b->capacity * sizeof(u32))
+        return;
+    data.big = b->copy(length, length);
+    b->del();
+}
+bool container::unique() const {
+    return is_small || data.big->unique();
+}
+void container::assign(container const &other) {
+    if (is_small || other.length > data.big->capacity || !data.big->unique() || shares(other)) {
+        *this = other;
+        return;
+    }
+    std::copy(other.span(), other.span() + other.length, data.big->limbs());
+    length = other.length;
+}
+void container::reverse() {
+    u32 *d = mutable_span();
+    std::reverse(d, d + length);
+}
+bool container::shares(container const &other) const {
+    return !is_small && !other.is_small && data.big == other.data.big && length == other.length;
 }
 container &container::operator=(container const &other) {
-    empty = other.empty;
-    if (!is_small)
-        data.big->del();
-    if (other.is_small)
-        data.small = other.data.small;
-    else
-        data.big = other.data.big->add();
+    // сначала захватываем чужой буфер: при самоприсваивании del() не должен его удалить
+    limb_buffer *old = is_small ? nullptr : data.big;
+    if (!other.is_small)
+        other.data.big->add();
+    data = other.data;
+    length = other.length;
     is_small = other.is_small;
+    if (old)
+        old->del();
+    return *this;
+}
+container &container::operator=(container &&other) noexcept {
+    swap(other);
     return *this;
 }
+void container::swap(container &other) noexcept {
+    // битовые поля по ссылке в std::swap не передать
+    size_t l = length, s = is_small;
+    length = other.length;
+    is_small = other.is_small;
+    other.length = l;
+    other.is_small = s;
+    std::swap(data, other.data);
+}
 
 bool operator==(container const &a, container const &b) {
-    if (a.empty && b.empty)
-        return true;
-    if (a.is_small == b.is_small) {
-        if (a.is_small && b.is_small)
-            return a.data.small == b.data.small;
-        else
-            return a.data.big->v == b.data.big->v;
-    }
-    return false;
-}
\ No newline at end of file
+    return a.size() == b.size() && std::equal(a.span(), a.span() + a.size(), b.span());
+}
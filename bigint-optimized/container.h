@@ -5,46 +5,117 @@
 #ifndef BIGINT__CONTAINER_H_
 #define BIGINT__CONTAINER_H_
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
-#include <memory>
-#include <variant>
-#include <vector>
+#include <new>
+#include "limb_pool.h"
+#ifdef BIGINT_ATOMIC_REFCOUNT
+#include <atomic>
+#endif
 
 #define u32 uint32_t
 
-struct wrapper{
-    std::vector<u32> v;
+// Общий буфер одним блоком: заголовок, сразу за ним лимбы. Одна аллокация
+// на значение, и до лимбов один переход по указателю. Длина хранится не здесь,
+// а в каждом владельце, так что владельцы общего буфера могут видеть разные
+// его префиксы.
+//
+// С BIGINT_ATOMIC_REFCOUNT счётчик ссылок атомарный, и копии одного значения
+// можно раздавать разным потокам; без него буфер должен жить в одном потоке.
+//
+// Память берётся из limb_pool, и вместимость — всё, что влезло в блок класса.
+struct limb_buffer {
+#ifdef BIGINT_ATOMIC_REFCOUNT
+    std::atomic<size_t> count;
+#else
     size_t count;
-    wrapper() : count(1) {    }
-    explicit wrapper(std::vector<u32>& other) : wrapper(){
-        v = other;
+#endif
+    size_t capacity;
+
+    limb_buffer() : count(1), capacity(0) {}
+
+    u32 *limbs() {
+        return reinterpret_cast<u32 *>(this + 1);
+    }
+    u32 const *limbs() const {
+        return reinterpret_cast<u32 const *>(this + 1);
+    }
+
+    // пустой буфер не меньше чем на capacity лимбов, count = 1
+    static limb_buffer *create(size_t capacity) {
+        size_t bytes = pool_block_size(sizeof(limb_buffer) + capacity * sizeof(u32));
+        limb_buffer *b = new (pool_allocate(bytes)) limb_buffer;
+        b->capacity = (bytes - sizeof(limb_buffer)) / sizeof(u32);
+        return b;
+    }
+
+    void release() {
+        size_t bytes = sizeof(limb_buffer) + capacity * sizeof(u32);
+        this->~limb_buffer();
+        pool_deallocate(this, bytes);
+    }
+
+#ifdef BIGINT_ATOMIC_REFCOUNT
+    // acq_rel: записи каждого владельца видны тому, кто освобождает память
+    void del() {
+        if (count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            release();
     }
-    void del(){
+
+    limb_buffer *add() {
+        count.fetch_add(1, std::memory_order_relaxed);
+        return this;
+    }
+
+    // acquire: после него можно писать в буфер, не мешая отпустившим его потокам
+    bool unique() const {
+        return count.load(std::memory_order_acquire) == 1;
+    }
+#else
+    void del() {
         count--;
         if (count == 0)
-            delete this;
+            release();
     }
 
-    wrapper* add(){
+    limb_buffer *add() {
         count++;
         return this;
     }
 
-    wrapper* unshare(){
-        if (count != 1) {
-            --count;
-            auto* nw = new wrapper;
-            nw->v = v;
-            return nw;
-        } else {
-            return this;
-        }
+    bool unique() const {
+        return count == 1;
+    }
+#endif
+
+    // вместимость ровно n лимбов, если блок от этого не меняет класс в пуле
+    // (release отдаёт блок по вместимости); false, если меняет
+    bool trim_capacity(size_t n) {
+        if (pool_block_size(sizeof(limb_buffer) + n * sizeof(u32)) !=
+            pool_block_size(sizeof(limb_buffer) + capacity * sizeof(u32)))
+            return false;
+        capacity = n;
+        return true;
+    }
+
+    // собственная копия первых n лимбов вместимостью не меньше capacity
+    limb_buffer *copy(size_t n, size_t capacity) const {
+        limb_buffer *b = create(capacity < n ? n : capacity);
+        std::copy(limbs(), limbs() + n, b->limbs());
+        return b;
     }
 };
 
+// до INLINE_LIMBS лимбов хранятся прямо в объекте, на месте указателя:
+// всё, что влезает в 64 бита, обходится без кучи. Единоличный буфер при
+// уменьшении значения остаётся у владельца, как вместимость std::vector;
+// внутрь объекта значение возвращает shrink_to_fit
+const size_t INLINE_LIMBS = 2;
+
 union myUnion {
-    u32 small;
-    wrapper *big;
+    u32 small[INLINE_LIMBS];
+    limb_buffer *big;
 };
 
 class container {
@@ -52,21 +123,58 @@ class container {
      container();
      ~container();
      container(container const& other);
+     // забирает буфер other, other становится пустым
+     container(container &&other) noexcept;
      explicit container(size_t i);
      void push_back(u32 v);
      void pop_back();
      u32 &operator[](size_t ind);
      u32 const &operator[](size_t ind) const;
      container &operator=(container const& other);
+     container &operator=(container &&other) noexcept;
+     void swap(container &other) noexcept;
      u32 &back();
+     // лимбы для записи: буфер делается единоличным один раз, дальше по
+     // указателю можно писать без проверок; действителен до изменения размера
+     u32 *mutable_span();
+     // лимбы только для чтения, общий буфер не копируется
+     u32 const *span() const;
+     // оставляет первые n лимбов разом, 1 <= n <= size()
+     void truncate(size_t n);
      size_t size() const;
      void resize(size_t sz);
      void resize(size_t sz, u32 v);
+     // сколько лимбов влезает в буфер; у общего буфера запись всё равно копирует
+     size_t capacity() const;
+     // единоличный буфер не меньше чем на n лимбов
+     void reserve(size_t n);
+     // отдаёт лишнюю вместимость единоличного буфера, до INLINE_LIMBS лимбов — внутрь объекта
+     void shrink_to_fit();
+     // true, если значение внутри объекта или буфер больше ни с кем не разделён
+     bool unique() const;
+     // значение other: копируется в свой буфер, если тот единоличный и вмещает
+     // его, иначе буфер other разделяется, как при присваивании
+     void assign(container const &other);
      void reverse();
-     bool is_small;
-     bool empty;
+     // true, если оба контейнера — одно значение в общем буфере: длина у
+     // владельцев своя, и общий буфер ещё не значит равенства
+     bool shares(container const &other) const;
+
+     // длина, флаг small и знак одним словом: вместе с data 16 байт
+     size_t length : 8 * sizeof(size_t) - 2;
+     size_t is_small : 1;
+     // знак big_integer, которому принадлежит контейнер; копирование,
+     // перемещение и обмен контейнеров его не трогают
+     size_t positive : 1;
      myUnion data;
 
+ private:
+     // делает буфер единоличным и вместимостью не меньше capacity
+     void own(size_t capacity);
+     // вместимость под рост до n лимбов: при нехватке хотя бы вдвое больше прежней
+     size_t grown(size_t n) const;
+     // переносит первые n <= INLINE_LIMBS лимбов буфера в small и отпускает буфер
+     void to_small(size_t n);
 };
 bool operator==(container const &a, container const &b);
 #endif //BIGINT__CONTAINER_H_
@@ -0,0 +1,168 @@
+#include "limb_div.h"
+#include "limb_kernels.h"
+#include "limb_scratch.h"
+
+#include <algorithm>
+
+static const uint64_t LIMB_BASE = static_cast<uint64_t>(1) << 32;
+
+static unsigned leading_zeros(u32 x) {
+    return static_cast<unsigned>(__builtin_clz(x));
+}
+
+// оценка floor(u1 u2 u3 / d1 d2) при u1 u2 <= d1 d2 и нормализованном d1;
+// результат больше точного не более чем на единицу
+static u32 div_3_2(u32 u1, u32 u2, u32 u3, u32 d1, u32 d2) {
+    uint64_t num = (static_cast<uint64_t>(u1) << 32) | u2;
+    uint64_t qhat;
+    uint64_t rhat;
+    if (u1 >= d1) {
+        qhat = LIMB_BASE - 1;
+        rhat = num - qhat * d1;
+    } else {
+        qhat = num / d1;
+        rhat = num % d1;
+    }
+    while (rhat < LIMB_BASE && qhat * d2 > ((rhat << 32) | u3)) {
+        qhat--;
+        rhat += d1;
+    }
+    return static_cast<u32>(qhat);
+}
+
+// floor((B^2 - 1) / d) - B для нормализованного d
+static u32 reciprocal(u32 d) {
+    return static_cast<u32>(((static_cast<uint64_t>(~d) << 32) | 0xFFFFFFFF) / d);
+}
+
+// деление u1 u0 на нормализованный d при u1 < d, v = reciprocal(d)
+static inline u32 div_2_1_preinv(u32 u1, u32 u0, u32 d, u32 v, u32 &r) {
+    uint64_t p = static_cast<uint64_t>(v) * u1 + ((static_cast<uint64_t>(u1) << 32) | u0);
+    u32 q = static_cast<u32>(p >> 32) + 1;
+    u32 rem = u0 - q * d;
+    if (rem > static_cast<u32>(p)) {
+        q--;
+        rem += d;
+    }
+    if (rem >= d) {
+        q++;
+        rem -= d;
+    }
+    r = rem;
+    return q;
+}
+
+// QUOT = false — только остаток, частное не записывается
+template<bool QUOT>
+static inline u32 divrem_1_preinv(u32 *q, u32 const *a, size_t n, u32 d, unsigned s, u32 v) {
+    u32 r = 0;
+    if (s == 0) {
+        for (size_t i = n; i-- != 0;) {
+            u32 t = div_2_1_preinv(r, a[i], d, v, r);
+            if (QUOT) {
+                q[i] = t;
+            }
+        }
+        return r;
+    }
+    u32 hi = a[n - 1];
+    r = hi >> (32 - s);
+    for (size_t i = n - 1; i != 0; i--) {
+        u32 lo = a[i - 1];
+        u32 t = div_2_1_preinv(r, (hi << s) | (lo >> (32 - s)), d, v, r);
+        if (QUOT) {
+            q[i] = t;
+        }
+        hi = lo;
+    }
+    u32 t = div_2_1_preinv(r, hi << s, d, v, r);
+    if (QUOT) {
+        q[0] = t;
+    }
+    return r >> s;
+}
+
+u32 divrem_1(u32 *q, u32 const *a, size_t n, u32 d) {
+    unsigned s = leading_zeros(d);
+    d <<= s;
+    return divrem_1_preinv<true>(q, a, n, d, s, reciprocal(d));
+}
+
+u32 mod_1(u32 const *a, size_t n, u32 d) {
+    unsigned s = leading_zeros(d);
+    d <<= s;
+    return divrem_1_preinv<false>(nullptr, a, n, d, s, reciprocal(d));
+}
+
+static const unsigned BILLION_SHIFT = 2;
+static const u32 BILLION_NORM = BILLION << BILLION_SHIFT;
+static const u32 BILLION_INV = static_cast<u32>(((static_cast<uint64_t>(~BILLION_NORM) << 32) | 0xFFFFFFFF) / BILLION_NORM);
+
+u32 divrem_1_billion(u32 *q, u32 const *a, size_t n) {
+    return divrem_1_preinv<true>(q, a, n, BILLION_NORM, BILLION_SHIFT, BILLION_INV);
+}
+
+void divrem_limbs(u32 *q, u32 *r, u32 const *a, size_t an, u32 const *d, size_t dn) {
+    kernel_table const &k = kernels();
+    unsigned s = leading_zeros(d[dn - 1]);
+    scratch_mark mark;
+    u32 *un = mark.alloc(an + 1);
+    u32 *vn = mark.alloc(dn);
+    if (s) {
+        k.lshift(vn, d, dn, s);
+        un[an] = k.lshift(un, a, an, s);
+    } else {
+        std::copy(d, d + dn, vn);
+        std::copy(a, a + an, un);
+        un[an] = 0;
+    }
+    u32 d1 = vn[dn - 1];
+    u32 d2 = vn[dn - 2];
+    for (size_t j = an - dn + 1; j-- != 0;) {
+        u32 *u = un + j;
+        u32 qhat = div_3_2(u[dn], u[dn - 1], u[dn - 2], d1, d2);
+        u32 borrow = k.submul_1(u, vn, dn, qhat);
+        bool negative = u[dn] < borrow;
+        u[dn] -= borrow;
+        if (negative) {
+            qhat--;
+            u[dn] += k.add_n(u, u, vn, dn);
+        }
+        q[j] = qhat;
+    }
+    if (s) {
+        k.rshift(r, un, dn, s);
+    } else {
+        std::copy(un, un + dn, r);
+    }
+}
+
+u32 binvert_limb(u32 d) {
+    // каждая итерация Ньютона удваивает число верных младших бит, начиная с 5
+    u32 x = (3 * d) ^ 2;
+    for (int i = 0; i < 3; i++) {
+        x *= 2 - d * x;
+    }
+    return x;
+}
+
+void divexact_limbs(u32 *q, u32 const *a, size_t an, u32 const *d, size_t dn) {
+    kernel_table const &k = kernels();
+    size_t qn = an - dn + 1;
+    // для частного важны только младшие qn лимбов делимого
+    scratch_mark mark;
+    u32 *u = mark.alloc(qn);
+    std::copy(a, a + qn, u);
+    u32 inv = binvert_limb(d[0]);
+    for (size_t i = 0; i < qn; i++) {
+        u32 qi = u[i] * inv;
+        q[i] = qi;
+        size_t len = std::min(dn, qn - i);
+        u32 borrow = k.submul_1(u + i, d, len, qi);
+        for (size_t j = i + len; borrow && j < qn; j++) {
+            u32 x = u[j];
+            u[j] = x - borrow;
+            borrow = x < borrow;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef BIGINT__LIMB_DIV_H_
+#define BIGINT__LIMB_DIV_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#define u32 uint32_t
+
+// Деление Кнута (алгоритм D) на массивах лимбов: делимое и делитель один раз
+// нормализуются во временные буферы, дальше каждая цифра частного — оценка
+// по трём старшим лимбам, submul_1 на месте и, редко, обратное прибавление.
+
+// q = a / d (an - dn + 1 лимбов), r = a % d (dn лимбов); an >= dn >= 2, d[dn - 1] != 0
+void divrem_limbs(u32 *q, u32 *r, u32 const *a, size_t an, u32 const *d, size_t dn);
+
+// точное деление от младших лимбов (Йебелеан, Хензель): q = a / d при d | a,
+// d[0] нечётен, q длины an - dn + 1; остаток не вычисляется и не проверяется
+void divexact_limbs(u32 *q, u32 const *a, size_t an, u32 const *d, size_t dn);
+// обратный к нечётному d по модулю 2^32
+u32 binvert_limb(u32 d);
+
+// Деление на один лимб умножением на заранее посчитанную обратную величину
+// нормализованного делителя (Мёллер—Гранлунд), без div в цикле.
+const u32 BILLION = 1000000000;
+
+// q = a / d, возвращает a % d; q может совпадать с a, d != 0
+u32 divrem_1(u32 *q, u32 const *a, size_t n, u32 d);
+// a % d без частного, d != 0
+u32 mod_1(u32 const *a, size_t n, u32 d);
+// то же для d = 10^9 с обратной величиной, посчитанной при компиляции
+u32 divrem_1_billion(u32 *q, u32 const *a, size_t n);
+
+#endif //BIGINT__LIMB_DIV_H_
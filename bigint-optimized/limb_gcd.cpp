@@ -0,0 +1,101 @@
+#include "limb_gcd.h"
+
+#include <limits>
+
+__extension__ typedef unsigned __int128 u128;
+__extension__ typedef __int128 i128;
+
+// сколько старших бит берётся в префикс: запас в 4 бита под кофакторы
+static const unsigned PREFIX_BITS = 124;
+static const i128 COFACTOR_LIMIT = std::numeric_limits<int64_t>::max();
+
+uint64_t gcd_u64(uint64_t a, uint64_t b) {
+    if (a == 0) {
+        return b;
+    }
+    if (b == 0) {
+        return a;
+    }
+    unsigned shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    while (b != 0) {
+        b >>= __builtin_ctzll(b);
+        if (a > b) {
+            uint64_t t = a;
+            a = b;
+            b = t;
+        }
+        b -= a;
+    }
+    return a << shift;
+}
+
+// старшие PREFIX_BITS бит x, выровненные по старшему биту числа длины n
+static u128 prefix(u32 const *x, size_t xn, size_t n, unsigned s) {
+    auto limb = [&](size_t i) { return i < xn ? x[i] : 0u; };
+    u128 t = 0;
+    for (size_t i = 1; i <= 4; i++) {
+        t = (t << 32) | limb(n - i);
+    }
+    if (s) {
+        t = (t << s) | (limb(n - 5) >> (32 - s));
+    }
+    return t >> (128 - PREFIX_BITS);
+}
+
+// частное почти всегда мало, а деление 128-битных чисел дорогое
+static u128 quotient(u128 num, u128 den) {
+    u128 q = 0;
+    while (num >= den && q < 4) {
+        num -= den;
+        q++;
+    }
+    return num < den ? q : q + num / den;
+}
+
+bool lehmer_step(u32 const *a, size_t n, u32 const *b, size_t bn, lehmer_matrix &m) {
+    unsigned s = static_cast<unsigned>(__builtin_clz(a[n - 1]));
+    i128 x = static_cast<i128>(prefix(a, n, n, s));
+    i128 y = static_cast<i128>(prefix(b, bn, n, s));
+    i128 A = 1, B = 0, C = 0, D = 1;
+    bool any = false;
+    while (y + C != 0 && y + D != 0) {
+        i128 q = static_cast<i128>(quotient(static_cast<u128>(x + A), static_cast<u128>(y + C)));
+        if (q == 0 || q != static_cast<i128>(quotient(static_cast<u128>(x + B), static_cast<u128>(y + D)))) {
+            break;
+        }
+        i128 t0 = A - q * C;
+        i128 t1 = B - q * D;
+        if (t0 > COFACTOR_LIMIT || t0 < -COFACTOR_LIMIT || t1 > COFACTOR_LIMIT || t1 < -COFACTOR_LIMIT) {
+            break;
+        }
+        A = C;
+        C = t0;
+        B = D;
+        D = t1;
+        i128 t = x - q * y;
+        x = y;
+        y = t;
+        any = true;
+    }
+    m.m00 = static_cast<int64_t>(A);
+    m.m01 = static_cast<int64_t>(B);
+    m.m10 = static_cast<int64_t>(C);
+    m.m11 = static_cast<int64_t>(D);
+    return any;
+}
+
+void lehmer_apply(u32 *r0, u32 *r1, u32 const *a, u32 const *b, size_t n, lehmer_matrix const &m) {
+    i128 c0 = 0;
+    i128 c1 = 0;
+    for (size_t i = 0; i < n; i++) {
+        i128 x = a[i];
+        i128 y = b[i];
+        c0 += m.m00 * x + m.m01 * y;
+        c1 += m.m10 * x + m.m11 * y;
+        r0[i] = static_cast<u32>(c0);
+        r1[i] = static_cast<u32>(c1);
+        c0 >>= 32;
+        c1 >>= 32;
+    }
+}
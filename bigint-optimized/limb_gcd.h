@@ -0,0 +1,36 @@
+#ifndef BIGINT__LIMB_GCD_H_
+#define BIGINT__LIMB_GCD_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#define u32 uint32_t
+
+// Шаг Лемера: алгоритм Евклида прогоняется по двойному машинному слову
+// (старшие 124 бита) вместо всего числа, и накопленная матрица применяется к
+// числам целиком за один проход. За шаг снимается около 62 бит, а сами
+// кофакторы занимают по два лимба.
+
+// с какой длины (в лимбах) НОД идёт через рекурсивный половинный НОД
+const size_t HGCD_THRESHOLD = 2000;
+
+// (a', b') = (m00 a + m01 b, m10 a + m11 b); в каждой строке знаки разные
+struct lehmer_matrix {
+    int64_t m00, m01;
+    int64_t m10, m11;
+};
+
+// НОД двух 64-битных чисел, бинарный алгоритм
+uint64_t gcd_u64(uint64_t a, uint64_t b);
+
+// Алгоритм L Кнута: a >= b, длина a равна n >= 5, b длины bn <= n.
+// Берёт только те частные, которые совпадают у a и b при любых младших
+// битах; false, если не подтверждено ни одного (нужно полное деление)
+bool lehmer_step(u32 const *a, size_t n, u32 const *b, size_t bn, lehmer_matrix &m);
+
+// r0 = m00 a + m01 b, r1 = m10 a + m11 b, все длины n; r0 и r1 могут совпадать
+// с a и b; результаты должны быть неотрицательны и помещаться в n лимбов
+// (для матрицы из lehmer_step это так)
+void lehmer_apply(u32 *r0, u32 *r1, u32 const *a, u32 const *b, size_t n, lehmer_matrix const &m);
+
+#endif //BIGINT__LIMB_GCD_H_
@@ -0,0 +1,603 @@
+#include "limb_kernels.h"
+#include "limb_scratch.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BIGINT_X86_KERNELS
+#include <cpuid.h>
+#include <immintrin.h>
+#define BIGINT_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+__extension__ typedef unsigned __int128 u128;
+
+// generic: по одному 32-битному лимбу за шаг
+
+static u32 add_n_generic(u32 *r, u32 const *a, u32 const *b, size_t n) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        carry += static_cast<uint64_t>(a[i]) + b[i];
+        r[i] = static_cast<u32>(carry);
+        carry >>= 32;
+    }
+    return static_cast<u32>(carry);
+}
+
+static u32 sub_n_generic(u32 *r, u32 const *a, u32 const *b, size_t n) {
+    u32 borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t t = static_cast<uint64_t>(a[i]) - b[i] - borrow;
+        r[i] = static_cast<u32>(t);
+        borrow = static_cast<u32>(t >> 63);
+    }
+    return borrow;
+}
+
+static u32 mul_1_generic(u32 *r, u32 const *a, size_t n, u32 b) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        carry += static_cast<uint64_t>(a[i]) * b;
+        r[i] = static_cast<u32>(carry);
+        carry >>= 32;
+    }
+    return static_cast<u32>(carry);
+}
+
+static u32 addmul_1_generic(u32 *r, u32 const *a, size_t n, u32 b) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        carry += static_cast<uint64_t>(a[i]) * b + r[i];
+        r[i] = static_cast<u32>(carry);
+        carry >>= 32;
+    }
+    return static_cast<u32>(carry);
+}
+
+static u32 submul_1_generic(u32 *r, u32 const *a, size_t n, u32 b) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        borrow += static_cast<uint64_t>(a[i]) * b;
+        u32 lo = static_cast<u32>(borrow);
+        borrow >>= 32;
+        borrow += r[i] < lo;
+        r[i] -= lo;
+    }
+    return static_cast<u32>(borrow);
+}
+
+// школьное умножение строками: r = b * a[0], затем r += b * a[i] со сдвигом
+template<u32 (*MUL_1)(u32 *, u32 const *, size_t, u32), u32 (*ADDMUL_1)(u32 *, u32 const *, size_t, u32)>
+static void mul_basecase_rows(u32 *r, u32 const *a, size_t n, u32 const *b, size_t m) {
+    r[m] = MUL_1(r, b, m, a[0]);
+    for (size_t i = 1; i < n; i++) {
+        r[i + m] = ADDMUL_1(r + i, b, m, a[i]);
+    }
+}
+
+static u32 lshift_generic(u32 *r, u32 const *a, size_t n, unsigned cnt) {
+    u32 out = a[n - 1] >> (32 - cnt);
+    for (size_t i = n - 1; i != 0; i--) {
+        r[i] = (a[i] << cnt) | (a[i - 1] >> (32 - cnt));
+    }
+    r[0] = a[0] << cnt;
+    return out;
+}
+
+static u32 rshift_generic(u32 *r, u32 const *a, size_t n, unsigned cnt) {
+    u32 out = a[0] << (32 - cnt);
+    for (size_t i = 0; i + 1 < n; i++) {
+        r[i] = (a[i] >> cnt) | (a[i + 1] << (32 - cnt));
+    }
+    r[n - 1] = a[n - 1] >> cnt;
+    return out;
+}
+
+#ifdef BIGINT_X86_KERNELS
+
+// bmi2/adx: по два лимба за шаг как одно 64-битное слово, mulx/adc
+
+static inline uint64_t load64(u32 const *p) {
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+static inline void store64(u32 *p, uint64_t x) {
+    memcpy(p, &x, sizeof(x));
+}
+
+BIGINT_TARGET("bmi2,adx")
+static u32 add_n_bmi2(u32 *r, u32 const *a, u32 const *b, size_t n) {
+    unsigned char c = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        unsigned long long s;
+        c = _addcarry_u64(c, load64(a + i), load64(b + i), &s);
+        store64(r + i, s);
+    }
+    if (i < n) {
+        uint64_t t = static_cast<uint64_t>(a[i]) + b[i] + c;
+        r[i] = static_cast<u32>(t);
+        c = static_cast<unsigned char>(t >> 32);
+    }
+    return c;
+}
+
+BIGINT_TARGET("bmi2,adx")
+static u32 sub_n_bmi2(u32 *r, u32 const *a, u32 const *b, size_t n) {
+    unsigned char c = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        unsigned long long s;
+        c = _subborrow_u64(c, load64(a + i), load64(b + i), &s);
+        store64(r + i, s);
+    }
+    if (i < n) {
+        uint64_t t = static_cast<uint64_t>(a[i]) - b[i] - c;
+        r[i] = static_cast<u32>(t);
+        c = static_cast<unsigned char>(t >> 63);
+    }
+    return c;
+}
+
+BIGINT_TARGET("bmi2,adx")
+static u32 mul_1_bmi2(u32 *r, u32 const *a, size_t n, u32 b) {
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        u128 p = static_cast<u128>(load64(a + i)) * b + carry;
+        store64(r + i, static_cast<uint64_t>(p));
+        carry = static_cast<uint64_t>(p >> 64);
+    }
+    if (i < n) {
+        carry += static_cast<uint64_t>(a[i]) * b;
+        r[i] = static_cast<u32>(carry);
+        carry >>= 32;
+    }
+    return static_cast<u32>(carry);
+}
+
+BIGINT_TARGET("bmi2,adx")
+static u32 addmul_1_bmi2(u32 *r, u32 const *a, size_t n, u32 b) {
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        u128 p = static_cast<u128>(load64(a + i)) * b + load64(r + i) + carry;
+        store64(r + i, static_cast<uint64_t>(p));
+        carry = static_cast<uint64_t>(p >> 64);
+    }
+    if (i < n) {
+        carry += static_cast<uint64_t>(a[i]) * b + r[i];
+        r[i] = static_cast<u32>(carry);
+        carry >>= 32;
+    }
+    return static_cast<u32>(carry);
+}
+
+// avx2/avx512: сдвиги по 8 и 16 лимбов за шаг
+
+BIGINT_TARGET("avx2")
+static u32 lshift_avx2(u32 *r, u32 const *a, size_t n, unsigned cnt) {
+    u32 out = a[n - 1] >> (32 - cnt);
+    __m128i sl = _mm_cvtsi32_si128(static_cast<int>(cnt));
+    __m128i sr = _mm_cvtsi32_si128(static_cast<int>(32 - cnt));
+    size_t i = n - 1;
+    for (; i >= 8; i -= 8) {
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + i - 7));
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + i - 8));
+        __m256i v = _mm256_or_si256(_mm256_sll_epi32(hi, sl), _mm256_srl_epi32(lo, sr));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i - 7), v);
+    }
+    for (; i != 0; i--) {
+        r[i] = (a[i] << cnt) | (a[i - 1] >> (32 - cnt));
+    }
+    r[0] = a[0] << cnt;
+    return out;
+}
+
+BIGINT_TARGET("avx2")
+static u32 rshift_avx2(u32 *r, u32 const *a, size_t n, unsigned cnt) {
+    u32 out = a[0] << (32 - cnt);
+    __m128i sr = _mm_cvtsi32_si128(static_cast<int>(cnt));
+    __m128i sl = _mm_cvtsi32_si128(static_cast<int>(32 - cnt));
+    size_t i = 0;
+    for (; i + 8 < n; i += 8) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + i));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + i + 1));
+        __m256i v = _mm256_or_si256(_mm256_srl_epi32(lo, sr), _mm256_sll_epi32(hi, sl));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), v);
+    }
+    for (; i + 1 < n; i++) {
+        r[i] = (a[i] >> cnt) | (a[i + 1] << (32 - cnt));
+    }
+    r[n - 1] = a[n - 1] >> cnt;
+    return out;
+}
+
+BIGINT_TARGET("bmi2,adx")
+static u32 submul_1_bmi2(u32 *r, u32 const *a, size_t n, u32 b) {
+    uint64_t borrow = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        u128 p = static_cast<u128>(load64(a + i)) * b + borrow;
+        uint64_t lo = static_cast<uint64_t>(p);
+        uint64_t x = load64(r + i);
+        borrow = static_cast<uint64_t>(p >> 64) + (x < lo);
+        store64(r + i, x - lo);
+    }
+    if (i < n) {
+        borrow += static_cast<uint64_t>(a[i]) * b;
+        u32 lo = static_cast<u32>(borrow);
+        borrow >>= 32;
+        borrow += r[i] < lo;
+        r[i] -= lo;
+    }
+    return static_cast<u32>(borrow);
+}
+
+// n обнулённых 64-битных слов на стеке временных
+static uint64_t *alloc_zero_u64(scratch_mark &mark, size_t n) {
+    uint64_t *p = reinterpret_cast<uint64_t *>(mark.alloc(2 * n));
+    std::fill(p, p + n, 0);
+    return p;
+}
+
+// avx2: произведения 32x32 считаются по четыре в 64-битных полях, младшие
+// и старшие половины копятся в разных массивах, переносы разносятся в конце
+
+BIGINT_TARGET("avx2")
+static void mul_basecase_avx2(u32 *r, u32 const *a, size_t n, u32 const *b, size_t m) {
+    if (n > m) {
+        std::swap(a, b);
+        std::swap(n, m);
+    }
+    if (n < 4 || n > (static_cast<size_t>(1) << 28)) {
+        mul_basecase_rows<mul_1_bmi2, addmul_1_bmi2>(r, a, n, b, m);
+        return;
+    }
+    size_t mp = (m + 3) & ~static_cast<size_t>(3);
+    scratch_mark mark;
+    u32 *bp = mark.alloc(mp);
+    std::copy(b, b + m, bp);
+    std::fill(bp + m, bp + mp, 0);
+    uint64_t *lo = alloc_zero_u64(mark, n + mp);
+    uint64_t *hi = alloc_zero_u64(mark, n + mp);
+    __m256i mask = _mm256_set1_epi64x(0xFFFFFFFF);
+    for (size_t i = 0; i < n; i++) {
+        __m256i ai = _mm256_set1_epi64x(a[i]);
+        uint64_t *pl = lo + i;
+        uint64_t *ph = hi + i;
+        for (size_t j = 0; j < mp; j += 4) {
+            __m256i bj = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const *>(bp + j)));
+            __m256i p = _mm256_mul_epu32(ai, bj);
+            __m256i l = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(pl + j));
+            __m256i h = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(ph + j));
+            l = _mm256_add_epi64(l, _mm256_and_si256(p, mask));
+            h = _mm256_add_epi64(h, _mm256_srli_epi64(p, 32));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(pl + j), l);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(ph + j), h);
+        }
+    }
+    uint64_t carry = 0;
+    for (size_t k = 0; k < n + m; k++) {
+        carry += lo[k] + (k ? hi[k - 1] : 0);
+        r[k] = static_cast<u32>(carry);
+        carry >>= 32;
+    }
+}
+
+// avx512 ifma: числа переводятся в цифры по 52 бита, vpmadd52luq/vpmadd52huq
+// дают младшие и старшие 52 бита произведений по восемь за шаг
+
+static const unsigned IFMA_BITS = 52;
+static const uint64_t IFMA_MASK = (static_cast<uint64_t>(1) << IFMA_BITS) - 1;
+
+static size_t to_radix52(uint64_t *d, u32 const *a, size_t n) {
+    size_t k = 0;
+    u128 window = 0;
+    unsigned bits = 0;
+    for (size_t i = 0; i < n; i++) {
+        window |= static_cast<u128>(a[i]) << bits;
+        bits += 32;
+        if (bits >= IFMA_BITS) {
+            d[k++] = static_cast<uint64_t>(window) & IFMA_MASK;
+            window >>= IFMA_BITS;
+            bits -= IFMA_BITS;
+        }
+    }
+    if (bits) {
+        d[k++] = static_cast<uint64_t>(window);
+    }
+    return k;
+}
+
+BIGINT_TARGET("avx512f,avx512ifma")
+static void mul_basecase_ifma(u32 *r, u32 const *a, size_t n, u32 const *b, size_t m) {
+    if (n > m) {
+        std::swap(a, b);
+        std::swap(n, m);
+    }
+    size_t na = (n * 32 + IFMA_BITS - 1) / IFMA_BITS;
+    size_t nb = (m * 32 + IFMA_BITS - 1) / IFMA_BITS;
+    // каждая позиция получает не больше na слагаемых < 2^52
+    if (na < 4 || na >= 4096) {
+        mul_basecase_avx2(r, a, n, b, m);
+        return;
+    }
+    size_t nbp = (nb + 7) & ~static_cast<size_t>(7);
+    scratch_mark mark;
+    uint64_t *da = alloc_zero_u64(mark, na);
+    uint64_t *db = alloc_zero_u64(mark, nbp);
+    to_radix52(da, a, n);
+    to_radix52(db, b, m);
+    uint64_t *lo = alloc_zero_u64(mark, na + nbp);
+    uint64_t *hi = alloc_zero_u64(mark, na + nbp);
+    for (size_t i = 0; i < na; i++) {
+        __m512i ai = _mm512_set1_epi64(static_cast<long long>(da[i]));
+        uint64_t *pl = lo + i;
+        uint64_t *ph = hi + i;
+        for (size_t j = 0; j < nbp; j += 8) {
+            __m512i bj = _mm512_loadu_si512(db + j);
+            __m512i l = _mm512_loadu_si512(pl + j);
+            __m512i h = _mm512_loadu_si512(ph + j);
+            _mm512_storeu_si512(pl + j, _mm512_madd52lo_epu64(l, ai, bj));
+            _mm512_storeu_si512(ph + j, _mm512_madd52hi_epu64(h, ai, bj));
+        }
+    }
+    u128 carry = 0;
+    u128 window = 0;
+    unsigned bits = 0;
+    size_t k = 0;
+    for (size_t t = 0; t < na + nb && k < n + m; t++) {
+        carry += lo[t];
+        if (t) {
+            carry += hi[t - 1];
+        }
+        window |= static_cast<u128>(static_cast<uint64_t>(carry) & IFMA_MASK) << bits;
+        carry >>= IFMA_BITS;
+        bits += IFMA_BITS;
+        while (bits >= 32 && k < n + m) {
+            r[k++] = static_cast<u32>(window);
+            window >>= 32;
+            bits -= 32;
+        }
+    }
+    window |= carry << bits;
+    for (; k < n + m; k++) {
+        r[k] = static_cast<u32>(window);
+        window >>= 32;
+    }
+}
+
+typedef u32 v16u32 __attribute__((vector_size(64)));
+
+BIGINT_TARGET("avx512f")
+static inline v16u32 load512(u32 const *p) {
+    v16u32 x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+BIGINT_TARGET("avx512f")
+static u32 lshift_avx512(u32 *r, u32 const *a, size_t n, unsigned cnt) {
+    u32 out = a[n - 1] >> (32 - cnt);
+    size_t i = n - 1;
+    for (; i >= 16; i -= 16) {
+        v16u32 v = (load512(a + i - 15) << cnt) | (load512(a + i - 16) >> (32 - cnt));
+        memcpy(r + i - 15, &v, sizeof(v));
+    }
+    for (; i != 0; i--) {
+        r[i] = (a[i] << cnt) | (a[i - 1] >> (32 - cnt));
+    }
+    r[0] = a[0] << cnt;
+    return out;
+}
+
+BIGINT_TARGET("avx512f")
+static u32 rshift_avx512(u32 *r, u32 const *a, size_t n, unsigned cnt) {
+    u32 out = a[0] << (32 - cnt);
+    size_t i = 0;
+    for (; i + 16 < n; i += 16) {
+        v16u32 v = (load512(a + i) >> cnt) | (load512(a + i + 1) << (32 - cnt));
+        memcpy(r + i, &v, sizeof(v));
+    }
+    for (; i + 1 < n; i++) {
+        r[i] = (a[i] >> cnt) | (a[i + 1] << (32 - cnt));
+    }
+    r[n - 1] = a[n - 1] >> cnt;
+    return out;
+}
+
+struct cpu_features {
+    bool bmi2 = false;
+    bool adx = false;
+    bool avx2 = false;
+    bool avx512f = false;
+    bool avx512ifma = false;
+};
+
+static uint64_t xgetbv0() {
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+static cpu_features detect_cpu() {
+    cpu_features f;
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return f;
+    }
+    bool osxsave = (ecx & bit_OSXSAVE) != 0;
+    uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    bool os_avx = (xcr0 & 0x6) == 0x6;
+    bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return f;
+    }
+    f.bmi2 = (ebx & bit_BMI2) != 0;
+    f.adx = (ebx & bit_ADX) != 0;
+    f.avx2 = os_avx && (ebx & bit_AVX2) != 0;
+    f.avx512f = os_avx512 && (ebx & bit_AVX512F) != 0;
+    f.avx512ifma = f.avx512f && (ebx & bit_AVX512IFMA) != 0;
+    return f;
+}
+
+static cpu_features const &cpu() {
+    static cpu_features f = detect_cpu();
+    return f;
+}
+
+#endif // BIGINT_X86_KERNELS
+
+bool kernel_tier_supported(kernel_tier tier) {
+    switch (tier) {
+        case kernel_tier::generic:
+            return true;
+#ifdef BIGINT_X86_KERNELS
+        case kernel_tier::bmi2:
+            return cpu().bmi2 && cpu().adx;
+        case kernel_tier::avx2:
+            return kernel_tier_supported(kernel_tier::bmi2) && cpu().avx2;
+        case kernel_tier::avx512:
+            return kernel_tier_supported(kernel_tier::avx2) && cpu().avx512f;
+#endif
+        default:
+            return false;
+    }
+}
+
+kernel_tier best_kernel_tier() {
+    kernel_tier tiers[] = {kernel_tier::avx512, kernel_tier::avx2, kernel_tier::bmi2};
+    for (kernel_tier t : tiers) {
+        if (kernel_tier_supported(t)) {
+            return t;
+        }
+    }
+    return kernel_tier::generic;
+}
+
+char const *kernel_tier_name(kernel_tier tier) {
+    switch (tier) {
+        case kernel_tier::bmi2:
+            return "bmi2";
+        case kernel_tier::avx2:
+            return "avx2";
+        case kernel_tier::avx512:
+            return "avx512";
+        default:
+            return "generic";
+    }
+}
+
+static kernel_table make_table(kernel_tier tier) {
+    kernel_table t;
+    t.tier = tier;
+    t.add_n = add_n_generic;
+    t.sub_n = sub_n_generic;
+    t.mul_1 = mul_1_generic;
+    t.addmul_1 = addmul_1_generic;
+    t.submul_1 = submul_1_generic;
+    t.mul_basecase = mul_basecase_rows<mul_1_generic, addmul_1_generic>;
+    t.karatsuba_threshold = 32;
+    t.sqr_threshold = 32;
+    t.lshift = lshift_generic;
+    t.rshift = rshift_generic;
+#ifdef BIGINT_X86_KERNELS
+    if (tier >= kernel_tier::bmi2) {
+        t.add_n = add_n_bmi2;
+        t.sub_n = sub_n_bmi2;
+        t.mul_1 = mul_1_bmi2;
+        t.addmul_1 = addmul_1_bmi2;
+        t.submul_1 = submul_1_bmi2;
+        t.mul_basecase = mul_basecase_rows<mul_1_bmi2, addmul_1_bmi2>;
+    }
+    if (tier >= kernel_tier::avx2) {
+        t.mul_basecase = mul_basecase_avx2;
+        t.karatsuba_threshold = 96;
+        t.sqr_threshold = 24;
+        t.lshift = lshift_avx2;
+        t.rshift = rshift_avx2;
+    }
+    if (tier >= kernel_tier::avx512) {
+        if (cpu().avx512ifma) {
+            t.mul_basecase = mul_basecase_ifma;
+            t.karatsuba_threshold = 512;
+            t.sqr_threshold = 48;
+        }
+        t.lshift = lshift_avx512;
+        t.rshift = rshift_avx512;
+    }
+#endif
+    return t;
+}
+
+static kernel_tier initial_tier() {
+    kernel_tier best = best_kernel_tier();
+    char const *forced = std::getenv("BIGINT_KERNEL_TIER");
+    if (forced == nullptr || *forced == 0) {
+        return best;
+    }
+    kernel_tier tiers[] = {kernel_tier::generic, kernel_tier::bmi2, kernel_tier::avx2, kernel_tier::avx512};
+    for (kernel_tier t : tiers) {
+        if (strcmp(forced, kernel_tier_name(t)) == 0) {
+            if (kernel_tier_supported(t)) {
+                return t;
+            }
+            std::cerr << "BIGINT_KERNEL_TIER=" << forced << " is not supported by this CPU, using "
+                      << kernel_tier_name(best) << std::endl;
+            return best;
+        }
+    }
+    std::cerr << "unknown BIGINT_KERNEL_TIER=" << forced << ", using " << kernel_tier_name(best) << std::endl;
+    return best;
+}
+
+static kernel_table &active_table() {
+    static kernel_table table = make_table(initial_tier());
+    return table;
+}
+
+kernel_table const &kernels() {
+    return active_table();
+}
+
+u32 add_limbs(u32 *r, u32 const *a, size_t an, u32 const *b, size_t bn) {
+    u32 carry = kernels().add_n(r, a, b, bn);
+    for (size_t i = bn; i < an; i++) {
+        r[i] = a[i] + carry;
+        carry = carry && r[i] == 0;
+    }
+    return carry;
+}
+
+u32 sub_limbs(u32 *r, u32 const *a, size_t an, u32 const *b, size_t bn) {
+    u32 borrow = kernels().sub_n(r, a, b, bn);
+    for (size_t i = bn; i < an; i++) {
+        u32 ai = a[i];
+        r[i] = ai - borrow;
+        borrow = borrow && ai == 0;
+    }
+    return borrow;
+}
+
+int cmp_limbs(u32 const *a, u32 const *b, size_t n) {
+    for (size_t i = n; i != 0; i--) {
+        if (a[i - 1] != b[i - 1]) {
+            return a[i - 1] < b[i - 1] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+bool set_kernel_tier(kernel_tier tier) {
+    if (!kernel_tier_supported(tier)) {
+        return false;
+    }
+    active_table() = make_table(tier);
+    return true;
+}
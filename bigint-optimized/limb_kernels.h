@@ -0,0 +1,58 @@
+#ifndef BIGINT__LIMB_KERNELS_H_
+#define BIGINT__LIMB_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#define u32 uint32_t
+
+// Низкоуровневые операции над массивами лимбов (младший лимб первый).
+// Реализация выбирается один раз при старте по CPUID; переменная окружения
+// BIGINT_KERNEL_TIER=generic|bmi2|avx2|avx512 принудительно задаёт уровень.
+
+enum class kernel_tier {
+    generic,
+    bmi2,
+    avx2,
+    avx512
+};
+
+struct kernel_table {
+    kernel_tier tier;
+    // r = a + b, возвращает перенос; r может совпадать с a или b
+    u32 (*add_n)(u32 *r, u32 const *a, u32 const *b, size_t n);
+    // r = a - b, возвращает заём; r может совпадать с a или b
+    u32 (*sub_n)(u32 *r, u32 const *a, u32 const *b, size_t n);
+    // r = a * b, возвращает старший лимб; r может совпадать с a
+    u32 (*mul_1)(u32 *r, u32 const *a, size_t n, u32 b);
+    // r += a * b, возвращает старший лимб
+    u32 (*addmul_1)(u32 *r, u32 const *a, size_t n, u32 b);
+    // r -= a * b, возвращает заём из старшего лимба
+    u32 (*submul_1)(u32 *r, u32 const *a, size_t n, u32 b);
+    // r = a * b, r длины n + m не пересекается с a и b
+    void (*mul_basecase)(u32 *r, u32 const *a, size_t n, u32 const *b, size_t m);
+    // длина, начиная с которой Карацуба обгоняет mul_basecase
+    size_t karatsuba_threshold;
+    // длина, до которой квадрат по треугольнику a[i] a[j], i < j, быстрее mul_basecase(a, a)
+    size_t sqr_threshold;
+    // r = a << cnt, 0 < cnt < 32, возвращает вытолкнутые биты; r >= a
+    u32 (*lshift)(u32 *r, u32 const *a, size_t n, unsigned cnt);
+    // r = a >> cnt, 0 < cnt < 32, возвращает вытолкнутые биты в старших разрядах; r <= a
+    u32 (*rshift)(u32 *r, u32 const *a, size_t n, unsigned cnt);
+};
+
+kernel_table const &kernels();
+
+// r = a + b, an >= bn, возвращает перенос
+u32 add_limbs(u32 *r, u32 const *a, size_t an, u32 const *b, size_t bn);
+// r = a - b, an >= bn, возвращает заём
+u32 sub_limbs(u32 *r, u32 const *a, size_t an, u32 const *b, size_t bn);
+int cmp_limbs(u32 const *a, u32 const *b, size_t n);
+
+bool kernel_tier_supported(kernel_tier tier);
+kernel_tier best_kernel_tier();
+// для тестов и бенчмарков; false, если процессор не поддерживает уровень
+bool set_kernel_tier(kernel_tier tier);
+char const *kernel_tier_name(kernel_tier tier);
+
+#endif //BIGINT__LIMB_KERNELS_H_
@@ -0,0 +1,206 @@
+#include "limb_mul.h"
+#include "limb_kernels.h"
+#include "limb_scratch.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <memory>
+
+static std::unique_ptr<thread_pool> pool;
+static size_t pool_threads = 1;
+
+void set_mul_threads(size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+    pool.reset();
+    if (threads > 1) {
+        pool.reset(new thread_pool(threads - 1));
+    }
+    pool_threads = threads;
+}
+
+size_t mul_threads() {
+    return pool_threads;
+}
+
+// r = |a - b| длины an, an >= bn; true, если a < b
+static bool abs_diff(u32 *r, u32 const *a, size_t an, u32 const *b, size_t bn) {
+    bool less = false;
+    size_t top = an;
+    while (top > bn && a[top - 1] == 0) {
+        top--;
+    }
+    if (top == bn) {
+        less = cmp_limbs(a, b, bn) < 0;
+    }
+    if (less) {
+        kernels().sub_n(r, b, a, bn);
+        std::fill(r + bn, r + an, 0);
+    } else {
+        sub_limbs(r, a, an, b, bn);
+    }
+    return less;
+}
+
+static void mul_unbalanced(u32 *r, u32 const *a, size_t an, u32 const *b, size_t bn) {
+    mul_limbs(r, a, bn, b, bn);
+    scratch_mark mark;
+    u32 *t = mark.alloc(2 * bn);
+    for (size_t off = bn; off < an; off += bn) {
+        size_t cn = std::min(bn, an - off);
+        mul_limbs(t, b, bn, a + off, cn);
+        // младшие bn лимбов куска накладываются на старшую часть предыдущего
+        u32 carry = kernels().add_n(r + off, r + off, t, bn);
+        for (size_t i = 0; i < cn; i++) {
+            r[off + bn + i] = t[bn + i] + carry;
+            carry = carry && r[off + bn + i] == 0;
+        }
+    }
+}
+
+static void mul_karatsuba(u32 *r, u32 const *a, size_t an, u32 const *b, size_t bn, size_t threads) {
+    size_t h = (an + 1) / 2;
+    size_t n1 = an - h;
+    size_t m1 = bn - h;
+    scratch_mark mark;
+    u32 *da = mark.alloc(6 * h + 1);
+    u32 *db = da + h;
+    u32 *t = db + h;
+    u32 *mid = t + 2 * h;
+
+    bool neg = abs_diff(da, a, h, a + h, n1);
+    neg ^= abs_diff(db, b, h, b + h, m1);
+    if (threads > 1 && h >= PARALLEL_MUL_THRESHOLD) {
+        // три независимых произведения делят между собой бюджет потоков
+        size_t share[3] = {threads / 3 + (threads % 3 > 0), threads / 3 + (threads % 3 > 1), threads / 3};
+        task_group group(*pool);
+        group.run([=] { mul_limbs_parallel(r + 2 * h, a + h, n1, b + h, m1, share[1]); });
+        if (share[2]) {
+            group.run([=] { mul_limbs_parallel(t, da, h, db, h, share[2]); });
+        }
+        mul_limbs_parallel(r, a, h, b, h, share[0]);
+        if (!share[2]) {
+            mul_limbs(t, da, h, db, h);
+        }
+        group.wait();
+    } else {
+        mul_limbs(r, a, h, b, h);
+        mul_limbs(r + 2 * h, a + h, n1, b + h, m1);
+        mul_limbs(t, da, h, db, h);
+    }
+
+    // a0 * b1 + a1 * b0 = a0 * b0 + a1 * b1 - (a0 - a1) * (b0 - b1)
+    mid[2 * h] = add_limbs(mid, r, 2 * h, r + 2 * h, n1 + m1);
+    if (neg) {
+        add_limbs(mid, mid, 2 * h + 1, t, 2 * h);
+    } else {
+        sub_limbs(mid, mid, 2 * h + 1, t, 2 * h);
+    }
+    size_t rest = an + bn - h;
+    add_limbs(r + h, r + h, rest, mid, std::min(2 * h + 1, rest));
+}
+
+void mul_limbs(u32 *r, u32 const *a, size_t an, u32 const *b, size_t bn) {
+    if (bn < kernels().karatsuba_threshold) {
+        kernels().mul_basecase(r, a, an, b, bn);
+    } else if (an >= UNBALANCED_RATIO * bn || 2 * bn <= an + 1) {
+        mul_unbalanced(r, a, an, b, bn);
+    } else {
+        mul_karatsuba(r, a, an, b, bn, 1);
+    }
+}
+
+// произведения a[i] a[j] при i < j считаются один раз, удваиваются сдвигом,
+// и к ним прибавляются квадраты на диагонали
+static void sqr_basecase(u32 *r, u32 const *a, size_t n) {
+    kernel_table const &k = kernels();
+    if (n == 1) {
+        uint64_t sq = static_cast<uint64_t>(a[0]) * a[0];
+        r[0] = static_cast<u32>(sq);
+        r[1] = static_cast<u32>(sq >> 32);
+        return;
+    }
+    r[0] = 0;
+    r[n] = k.mul_1(r + 1, a + 1, n - 1, a[0]);
+    for (size_t i = 1; i + 1 < n; i++) {
+        r[n + i] = k.addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+    r[2 * n - 1] = k.lshift(r + 1, r + 1, 2 * n - 2, 1);
+    u32 carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t sq = static_cast<uint64_t>(a[i]) * a[i];
+        uint64_t lo = static_cast<uint64_t>(r[2 * i]) + static_cast<u32>(sq) + carry;
+        uint64_t hi = static_cast<uint64_t>(r[2 * i + 1]) + (sq >> 32) + (lo >> 32);
+        r[2 * i] = static_cast<u32>(lo);
+        r[2 * i + 1] = static_cast<u32>(hi);
+        carry = static_cast<u32>(hi >> 32);
+    }
+}
+
+// a^2 = a0^2 + (a0^2 + a1^2 - (a0 - a1)^2) B^h + a1^2 B^2h: три квадрата половинной длины
+static void sqr_karatsuba(u32 *r, u32 const *a, size_t n) {
+    size_t h = (n + 1) / 2;
+    size_t n1 = n - h;
+    scratch_mark mark;
+    u32 *d = mark.alloc(5 * h + 1);
+    u32 *t = d + h;
+    u32 *mid = t + 2 * h;
+    abs_diff(d, a, h, a + h, n1);
+    sqr_limbs(r, a, h);
+    sqr_limbs(r + 2 * h, a + h, n1);
+    sqr_limbs(t, d, h);
+    mid[2 * h] = add_limbs(mid, r, 2 * h, r + 2 * h, 2 * n1);
+    sub_limbs(mid, mid, 2 * h + 1, t, 2 * h);
+    size_t rest = 2 * n - h;
+    add_limbs(r + h, r + h, rest, mid, std::min(2 * h + 1, rest));
+}
+
+void sqr_limbs(u32 *r, u32 const *a, size_t n) {
+    kernel_table const &k = kernels();
+    if (n >= k.karatsuba_threshold) {
+        sqr_karatsuba(r, a, n);
+    } else if (n < k.sqr_threshold) {
+        sqr_basecase(r, a, n);
+    } else {
+        k.mul_basecase(r, a, n, a, n);
+    }
+}
+
+// куски с чётными номерами не пересекаются и пишутся прямо в r, с нечётными —
+// во временный массив, который в конце прибавляется к r
+static void mul_unbalanced_parallel(u32 *r, u32 const *a, size_t an, u32 const *b, size_t bn, size_t threads) {
+    size_t chunks = (an + bn - 1) / bn;
+    scratch_mark mark;
+    u32 *odd_ptr = mark.alloc(an + bn);
+    std::fill(odd_ptr, odd_ptr + an + bn, 0);
+    std::fill(r, r + an + bn, 0);
+    size_t workers = std::min(threads, chunks);
+    task_group group(*pool);
+    for (size_t w = 0; w < workers; w++) {
+        size_t budget = chunks < threads ? threads / chunks + (w < threads % chunks) : 1;
+        auto job = [=] {
+            for (size_t k = w; k < chunks; k += workers) {
+                size_t cn = std::min(bn, an - k * bn);
+                u32 *dst = (k % 2 == 0 ? r : odd_ptr) + k * bn;
+                mul_limbs_parallel(dst, b, bn, a + k * bn, cn, budget);
+            }
+        };
+        if (w + 1 == workers) {
+            job();
+        } else {
+            group.run(job);
+        }
+    }
+    group.wait();
+    kernels().add_n(r, r, odd_ptr, an + bn);
+}
+
+void mul_limbs_parallel(u32 *r, u32 const *a, size_t an, u32 const *b, size_t bn, size_t max_threads) {
+    size_t threads = pool ? std::min(max_threads, pool_threads) : 1;
+    if (threads <= 1 || an * bn < PARALLEL_MUL_THRESHOLD * PARALLEL_MUL_THRESHOLD) {
+        mul_limbs(r, a, an, b, bn);
+    } else if (an >= UNBALANCED_RATIO * bn || 2 * bn <= an + 1) {
+        mul_unbalanced_parallel(r, a, an, b, bn, threads);
+    } else {
+        mul_karatsuba(r, a, an, b, bn, threads);
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef BIGINT__LIMB_MUL_H_
+#define BIGINT__LIMB_MUL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#define u32 uint32_t
+
+// Умножение массивов лимбов: школьное для множителей короче
+// kernels().karatsuba_threshold, Карацуба для сопоставимых длин и нарезка
+// длинного множителя на куски длины короткого, если длины отличаются хотя
+// бы в UNBALANCED_RATIO раз.
+
+const size_t UNBALANCED_RATIO = 2;
+// умножения с произведением длин меньше PARALLEL_MUL_THRESHOLD^2 не делятся между потоками
+const size_t PARALLEL_MUL_THRESHOLD = 1024;
+
+// r = a * b, an >= bn >= 1, r длины an + bn не пересекается с a и b
+void mul_limbs(u32 *r, u32 const *a, size_t an, u32 const *b, size_t bn);
+// r = a^2, r длины 2n не пересекается с a; короткие — по треугольнику
+// произведений, длинные — Карацубой через три квадрата половинной длины
+void sqr_limbs(u32 *r, u32 const *a, size_t n);
+// то же, но ветви Карацубы и куски несбалансированного умножения выполняются
+// параллельно, одновременно работают не больше max_threads потоков
+void mul_limbs_parallel(u32 *r, u32 const *a, size_t an, u32 const *b, size_t bn, size_t max_threads);
+
+// размер общего пула для умножения, по умолчанию 1 (всё в вызывающем потоке);
+// не должен меняться во время умножений
+void set_mul_threads(size_t threads);
+size_t mul_threads();
+
+#endif //BIGINT__LIMB_MUL_H_
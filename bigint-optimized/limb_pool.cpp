@@ -0,0 +1,125 @@
+// Копия этого файла лежит в bigint/limb_pool.cpp; правки вносятся в обе.
+#include "limb_pool.h"
+
+#include <atomic>
+#include <new>
+
+namespace {
+// классы POOL_MIN_BLOCK << c для c < CLASSES, последний — POOL_MAX_BLOCK
+const size_t CLASSES = 12;
+
+std::atomic<size_t> limit(static_cast<size_t>(1) << 20);
+// сумма retained по всем потокам
+std::atomic<size_t> total(0);
+
+struct free_block {
+    free_block *next;
+};
+
+// без конструктора и деструктора: доступен в потоке в любой момент, в том
+// числе когда деструкторы thread_local уже отработали
+struct thread_cache {
+    free_block *lists[CLASSES];
+    pool_stats stats;
+    bool registered;
+    bool closed;
+};
+
+thread_local thread_cache cache;
+
+void trim(thread_cache &t) {
+    for (size_t c = 0; c < CLASSES; c++) {
+        while (free_block *b = t.lists[c]) {
+            t.lists[c] = b->next;
+            operator delete(b);
+        }
+    }
+    total.fetch_sub(t.stats.retained, std::memory_order_relaxed);
+    t.stats.retained = 0;
+}
+
+// на выходе из потока отдаёт его списки в кучу; после этого блоки потока в
+// списки не попадают
+struct cache_guard {
+    void touch() {}
+    ~cache_guard() {
+        trim(cache);
+        cache.closed = true;
+    }
+};
+
+thread_local cache_guard guard;
+
+size_t class_of(size_t bytes) {
+    if (bytes <= POOL_MIN_BLOCK) {
+        return 0;
+    }
+    return 64 - __builtin_clzll(bytes - 1) - 5;
+}
+}
+
+size_t pool_block_size(size_t bytes) {
+    return bytes > POOL_MAX_BLOCK ? bytes : POOL_MIN_BLOCK << class_of(bytes);
+}
+
+void *pool_allocate(size_t bytes) {
+    thread_cache &t = cache;
+    if (bytes > POOL_MAX_BLOCK) {
+        t.stats.misses++;
+        return operator new(bytes);
+    }
+    size_t c = class_of(bytes);
+    if (free_block *b = t.lists[c]) {
+        t.lists[c] = b->next;
+        t.stats.hits++;
+        t.stats.retained -= POOL_MIN_BLOCK << c;
+        total.fetch_sub(POOL_MIN_BLOCK << c, std::memory_order_relaxed);
+        return b;
+    }
+    t.stats.misses++;
+    return operator new(POOL_MIN_BLOCK << c);
+}
+
+void pool_deallocate(void *p, size_t bytes) {
+    thread_cache &t = cache;
+    size_t size = pool_block_size(bytes);
+    if (bytes > POOL_MAX_BLOCK || t.closed) {
+        operator delete(p);
+        return;
+    }
+    // место под блок занимается до проверки, чтобы потоки вместе не вышли за предел
+    if (total.fetch_add(size, std::memory_order_relaxed) + size > limit.load(std::memory_order_relaxed)) {
+        total.fetch_sub(size, std::memory_order_relaxed);
+        operator delete(p);
+        return;
+    }
+    if (!t.registered) {
+        t.registered = true;
+        guard.touch();
+    }
+    free_block *b = static_cast<free_block *>(p);
+    size_t c = class_of(bytes);
+    b->next = t.lists[c];
+    t.lists[c] = b;
+    t.stats.retained += size;
+}
+
+void set_pool_limit(size_t bytes) {
+    limit.store(bytes, std::memory_order_relaxed);
+}
+
+size_t pool_limit() {
+    return limit.load(std::memory_order_relaxed);
+}
+
+pool_stats pool_statistics() {
+    return cache.stats;
+}
+
+size_t pool_retained() {
+    return total.load(std::memory_order_relaxed);
+}
+
+void pool_trim() {
+    trim(cache);
+}
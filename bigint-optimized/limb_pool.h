@@ -0,0 +1,69 @@
+#ifndef BIGINT__LIMB_POOL_H_
+#define BIGINT__LIMB_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// Пул памяти под лимбы. Размер запроса округляется вверх до степени двойки,
+// у каждого потока свои списки свободных блоков по этим классам: освобождённый
+// блок ложится в список своего потока и отдаётся следующему запросу того же
+// класса без обращения к куче. Блоки больше POOL_MAX_BLOCK идут прямо в кучу.
+// Блок можно освободить в другом потоке: он попадёт в список освободившего.
+// Копия этого файла лежит в bigint/limb_pool.h; правки вносятся в обе.
+
+const size_t POOL_MIN_BLOCK = 32;
+const size_t POOL_MAX_BLOCK = static_cast<size_t>(1) << 16;
+
+// сколько байт на самом деле получит запрос на bytes байт
+size_t pool_block_size(size_t bytes);
+void *pool_allocate(size_t bytes);
+// bytes — размер, с которым блок выделялся, или любой с тем же pool_block_size
+void pool_deallocate(void *p, size_t bytes);
+
+// сколько байт могут держать в списках все потоки вместе; сверх него
+// освобождённые блоки сразу уходят в кучу, 0 выключает пул
+void set_pool_limit(size_t bytes);
+size_t pool_limit();
+
+struct pool_stats {
+    // запросы, обслуженные из списков
+    uint64_t hits;
+    // запросы, ушедшие в кучу
+    uint64_t misses;
+    // байт лежит в списках
+    size_t retained;
+};
+// счётчики текущего потока
+pool_stats pool_statistics();
+// байт лежит в списках всех потоков — то, что сравнивается с pool_limit
+size_t pool_retained();
+// возвращает в кучу всё, что лежит в списках текущего потока
+void pool_trim();
+
+// аллокатор для std::vector поверх пула
+template<typename T>
+struct pool_allocator {
+    typedef T value_type;
+
+    pool_allocator() noexcept {}
+    template<typename U>
+    pool_allocator(pool_allocator<U> const &) noexcept {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(pool_allocate(n * sizeof(T)));
+    }
+    void deallocate(T *p, size_t n) noexcept {
+        pool_deallocate(p, n * sizeof(T));
+    }
+};
+
+template<typename T, typename U>
+bool operator==(pool_allocator<T> const &, pool_allocator<U> const &) {
+    return true;
+}
+template<typename T, typename U>
+bool operator!=(pool_allocator<T> const &, pool_allocator<U> const &) {
+    return false;
+}
+
+#endif //BIGINT__LIMB_POOL_H_
@@ -0,0 +1,368 @@
+#include "limb_prime.h"
+#include "limb_kernels.h"
+#include "limb_mul.h"
+#include "limb_div.h"
+#include "limb_scratch.h"
+#include "primes.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+// простые таблицы, сгруппированные так, чтобы произведение группы влезало в
+// лимб: один mod_1 по числу на группу вместо одного на каждое простое
+struct trial_table {
+    std::vector<u32> primes;
+    std::vector<u32> products;
+    std::vector<size_t> ends;
+
+    trial_table() : primes(primes_up_to(TRIAL_DIVISION_LIMIT - 1)) {
+        uint64_t prod = 1;
+        for (size_t i = 1; i < primes.size(); i++) {
+            if (prod * primes[i] >> 32) {
+                products.push_back(static_cast<u32>(prod));
+                ends.push_back(i);
+                prod = 1;
+            }
+            prod *= primes[i];
+        }
+        products.push_back(static_cast<u32>(prod));
+        ends.push_back(primes.size());
+    }
+};
+
+trial_table const &trial() {
+    static const trial_table t;
+    return t;
+}
+
+// символ Якоби (a / b) для нечётного b
+int jacobi_u32(u32 a, u32 b) {
+    int s = 1;
+    a %= b;
+    while (a != 0) {
+        while ((a & 1) == 0) {
+            a >>= 1;
+            if ((b & 7) == 3 || (b & 7) == 5) {
+                s = -s;
+            }
+        }
+        if ((a & 3) == 3 && (b & 3) == 3) {
+            s = -s;
+        }
+        u32 t = a;
+        a = b % t;
+        b = t;
+    }
+    return b == 1 ? s : 0;
+}
+
+// (d / m) для нечётных d и m через квадратичный закон взаимности
+int jacobi(int64_t d, u32 const *m, size_t n) {
+    int s = 1;
+    if (d < 0 && (m[0] & 3) == 3) {
+        s = -s;
+    }
+    u32 a = static_cast<u32>(std::llabs(d));
+    if ((a & 3) == 3 && (m[0] & 3) == 3) {
+        s = -s;
+    }
+    return s * jacobi_u32(mod_1(m, n, a), a);
+}
+
+bool is_zero(u32 const *a, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool equal(u32 const *a, u32 const *b, size_t n) {
+    return cmp_limbs(a, b, n) == 0;
+}
+
+// a >>= k бит на месте, длина n
+void shift_right(u32 *a, size_t n, size_t k) {
+    size_t limbs = k / 32;
+    if (limbs) {
+        for (size_t i = 0; i < n; i++) {
+            a[i] = i + limbs < n ? a[i + limbs] : 0;
+        }
+    }
+    if (k % 32) {
+        kernels().rshift(a, a, n, static_cast<unsigned>(k % 32));
+    }
+}
+
+size_t trailing_zeros(u32 const *a) {
+    size_t z = 0;
+    while (a[z / 32] == 0) {
+        z += 32;
+    }
+    return z + __builtin_ctz(a[z / 32]);
+}
+
+// вычет малого по модулю d по модулю m
+void small_residue(u32 *r, int64_t d, u32 const *m, size_t n) {
+    std::fill(r, r + n, 0);
+    r[0] = static_cast<u32>(std::llabs(d));
+    if (d < 0) {
+        kernels().sub_n(r, m, r, n);
+    }
+}
+}
+
+std::vector<u32> const &small_primes() {
+    return trial().primes;
+}
+
+bool has_small_factor(u32 const *a, size_t n) {
+    trial_table const &t = trial();
+    if ((a[0] & 1) == 0) {
+        return true;
+    }
+    size_t begin = 1;
+    for (size_t g = 0; g < t.products.size(); g++) {
+        u32 r = mod_1(a, n, t.products[g]);
+        for (size_t i = begin; i < t.ends[g]; i++) {
+            if (r % t.primes[i] == 0) {
+                return true;
+            }
+        }
+        begin = t.ends[g];
+    }
+    return false;
+}
+
+montgomery::montgomery(u32 const *m, size_t n)
+    : n_(n), m_(m, m + n), minv_(0 - binvert_limb(m[0])), r2_(n), one_(n), t_(2 * n + 1) {
+    // R^2 mod m и R mod m одним делением каждое
+    scratch_mark mark;
+    u32 *x = mark.alloc(2 * n + 1);
+    u32 *q = mark.alloc(2 * n + 1);
+    std::fill(x, x + 2 * n, 0);
+    x[2 * n] = 1;
+    if (n == 1) {
+        r2_[0] = divrem_1(q, x, 3, m[0]);
+        one_[0] = divrem_1(q, x + 1, 2, m[0]);
+    } else {
+        divrem_limbs(q, &r2_[0], x, 2 * n + 1, m, n);
+        divrem_limbs(q, &one_[0], x + n, n + 1, m, n);
+    }
+}
+
+size_t montgomery::size() const {
+    return n_;
+}
+
+u32 const *montgomery::one() const {
+    return &one_[0];
+}
+
+void montgomery::redc(u32 *r) const {
+    kernel_table const &k = kernels();
+    u32 *t = &t_[0];
+    u32 top = 0;
+    for (size_t i = 0; i < n_; i++) {
+        u32 c = k.addmul_1(t + i, &m_[0], n_, t[i] * minv_);
+        uint64_t s = static_cast<uint64_t>(t[i + n_]) + c + top;
+        t[i + n_] = static_cast<u32>(s);
+        top = static_cast<u32>(s >> 32);
+    }
+    // t / R < 2m
+    if (top || cmp_limbs(t + n_, &m_[0], n_) >= 0) {
+        k.sub_n(r, t + n_, &m_[0], n_);
+    } else {
+        std::copy(t + n_, t + 2 * n_, r);
+    }
+}
+
+void montgomery::mul(u32 *r, u32 const *a, u32 const *b) const {
+    mul_limbs(&t_[0], a, n_, b, n_);
+    t_[2 * n_] = 0;
+    redc(r);
+}
+
+void montgomery::sqr(u32 *r, u32 const *a) const {
+    sqr_limbs(&t_[0], a, n_);
+    t_[2 * n_] = 0;
+    redc(r);
+}
+
+void montgomery::to_mont(u32 *r, u32 const *a) const {
+    mul(r, a, &r2_[0]);
+}
+
+void montgomery::from_mont(u32 *r, u32 const *a) const {
+    std::fill(t_.begin(), t_.end(), 0);
+    std::copy(a, a + n_, t_.begin());
+    redc(r);
+}
+
+void montgomery::add(u32 *r, u32 const *a, u32 const *b) const {
+    kernel_table const &k = kernels();
+    if (k.add_n(r, a, b, n_) || cmp_limbs(r, &m_[0], n_) >= 0) {
+        k.sub_n(r, r, &m_[0], n_);
+    }
+}
+
+void montgomery::sub(u32 *r, u32 const *a, u32 const *b) const {
+    kernel_table const &k = kernels();
+    if (k.sub_n(r, a, b, n_)) {
+        k.add_n(r, r, &m_[0], n_);
+    }
+}
+
+void montgomery::half(u32 *r, u32 const *a) const {
+    kernel_table const &k = kernels();
+    u32 carry = 0;
+    if (a[0] & 1) {
+        carry = k.add_n(r, a, &m_[0], n_);
+    } else if (r != a) {
+        std::copy(a, a + n_, r);
+    }
+    k.rshift(r, r, n_, 1);
+    r[n_ - 1] |= carry << 31;
+}
+
+void montgomery::pow(u32 *r, u32 const *a, u32 const *e, size_t en) const {
+    // фиксированное окно в 4 бита: таблица a^0 .. a^15
+    scratch_mark mark;
+    u32 *table = mark.alloc(16 * n_);
+    std::copy(one_.begin(), one_.end(), table);
+    std::copy(a, a + n_, table + n_);
+    for (size_t i = 2; i < 16; i++) {
+        mul(table + i * n_, table + (i - 1) * n_, a);
+    }
+    std::copy(one_.begin(), one_.end(), r);
+    bool started = false;
+    for (size_t i = en * 8; i-- > 0;) {
+        u32 digit = (e[i / 8] >> (i % 8 * 4)) & 15;
+        if (started) {
+            for (int j = 0; j < 4; j++) {
+                sqr(r, r);
+            }
+        }
+        if (digit) {
+            mul(r, r, table + digit * n_);
+            started = true;
+        }
+    }
+}
+
+bool miller_rabin(montgomery const &mt, u32 const *m, u32 base) {
+    size_t n = mt.size();
+    // m - 1 = d 2^s, d нечётно
+    scratch_mark mark;
+    u32 *d = mark.alloc(n);
+    std::copy(m, m + n, d);
+    d[0] -= 1;
+    size_t s = trailing_zeros(d);
+    shift_right(d, n, s);
+    u32 *minus_one = mark.alloc(n);
+    kernels().sub_n(minus_one, m, mt.one(), n);
+
+    u32 *x = mark.alloc(n);
+    u32 *b = mark.alloc(n);
+    std::fill(b, b + n, 0);
+    b[0] = base;
+    mt.to_mont(b, b);
+    mt.pow(x, b, d, n);
+    if (equal(x, mt.one(), n) || equal(x, minus_one, n)) {
+        return true;
+    }
+    for (size_t i = 1; i < s; i++) {
+        mt.sqr(x, x);
+        if (equal(x, minus_one, n)) {
+            return true;
+        }
+        if (equal(x, mt.one(), n)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool strong_lucas(montgomery const &mt, u32 const *m) {
+    size_t n = mt.size();
+    int64_t dd = 5;
+    while (true) {
+        int j = jacobi(dd, m, n);
+        if (j == -1) {
+            break;
+        }
+        // |D| < m, так что (D / m) = 0 означает общий делитель
+        if (j == 0) {
+            return false;
+        }
+        dd = dd > 0 ? -(dd + 2) : -dd + 2;
+    }
+    int64_t qq = (1 - dd) / 4;
+
+    // m + 1 = d 2^s, d нечётно; m + 1 может не влезть в n лимбов
+    scratch_mark mark;
+    u32 *d = mark.alloc(n + 1);
+    std::copy(m, m + n, d);
+    d[n] = 0;
+    size_t i = 0;
+    while (++d[i] == 0) {
+        i++;
+    }
+    size_t s = trailing_zeros(d);
+    shift_right(d, n + 1, s);
+    size_t dn = n + 1;
+    while (d[dn - 1] == 0) {
+        dn--;
+    }
+
+    u32 *dm = mark.alloc(n);
+    u32 *q = mark.alloc(n);
+    small_residue(dm, dd, m, n);
+    small_residue(q, qq, m, n);
+    mt.to_mont(dm, dm);
+    mt.to_mont(q, q);
+
+    // U_k, V_k и Q^k начиная с k = 1, по битам d от старшего
+    u32 *u = mark.alloc(n);
+    u32 *v = mark.alloc(n);
+    u32 *qk = mark.alloc(n);
+    u32 *t = mark.alloc(n);
+    std::copy(mt.one(), mt.one() + n, u);
+    std::copy(u, u + n, v);
+    std::copy(q, q + n, qk);
+    size_t top = 32 * dn - __builtin_clz(d[dn - 1]) - 1;
+    for (i = top; i-- > 0;) {
+        // U_2k = U_k V_k, V_2k = V_k^2 - 2 Q^k
+        mt.mul(u, u, v);
+        mt.sqr(v, v);
+        mt.add(t, qk, qk);
+        mt.sub(v, v, t);
+        mt.sqr(qk, qk);
+        if ((d[i / 32] >> (i % 32)) & 1) {
+            // U_k+1 = (U_k + V_k) / 2, V_k+1 = (D U_k + V_k) / 2
+            mt.mul(t, dm, u);
+            mt.add(t, t, v);
+            mt.add(u, u, v);
+            mt.half(u, u);
+            mt.half(v, t);
+            mt.mul(qk, qk, q);
+        }
+    }
+    if (is_zero(u, n)) {
+        return true;
+    }
+    for (size_t r = 0; r < s; r++) {
+        if (is_zero(v, n)) {
+            return true;
+        }
+        if (r + 1 < s) {
+            mt.sqr(v, v);
+            mt.add(t, qk, qk);
+            mt.sub(v, v, t);
+            mt.sqr(qk, qk);
+        }
+    }
+    return false;
+}
@@ -0,0 +1,65 @@
+#ifndef BIGINT__LIMB_PRIME_H_
+#define BIGINT__LIMB_PRIME_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define u32 uint32_t
+
+// Тест простоты BPSW на массивах лимбов: пробное деление по таблице малых
+// простых, сильный тест Ферма по основанию 2 и сильный тест Люка с
+// параметрами Селфриджа. Вся модульная арифметика — в форме Монтгомери,
+// так что в возведении в степень нет ни одного деления.
+
+// пробное деление идёт по простым меньше этой границы
+const u32 TRIAL_DIVISION_LIMIT = 1000;
+
+// простые меньше TRIAL_DIVISION_LIMIT по возрастанию
+std::vector<u32> const &small_primes();
+
+// делится ли a длины n на простое из таблицы; a > TRIAL_DIVISION_LIMIT
+bool has_small_factor(u32 const *a, size_t n);
+
+// Арифметика по нечётному модулю m > 1 длины n, R = 2^(32n): числа хранятся
+// как x R mod m, умножение — произведение и редукция Монтгомери (REDC).
+// Все операнды — n лимбов, меньше m; результат может совпадать с операндом.
+class montgomery {
+ public:
+     montgomery(u32 const *m, size_t n);
+
+     size_t size() const;
+     // R mod m — единица в форме Монтгомери
+     u32 const *one() const;
+
+     void to_mont(u32 *r, u32 const *a) const;
+     void from_mont(u32 *r, u32 const *a) const;
+     void mul(u32 *r, u32 const *a, u32 const *b) const;
+     void sqr(u32 *r, u32 const *a) const;
+     void add(u32 *r, u32 const *a, u32 const *b) const;
+     void sub(u32 *r, u32 const *a, u32 const *b) const;
+     // a / 2 mod m
+     void half(u32 *r, u32 const *a) const;
+     // r = a^e, e длины en; r не совпадает с a
+     void pow(u32 *r, u32 const *a, u32 const *e, size_t en) const;
+
+ private:
+     void redc(u32 *r) const;
+
+     size_t n_;
+     std::vector<u32> m_;
+     // -m^(-1) mod 2^32
+     u32 minv_;
+     std::vector<u32> r2_;
+     std::vector<u32> one_;
+     // произведение перед редукцией, 2n + 1 лимбов
+     mutable std::vector<u32> t_;
+};
+
+// сильный тест Ферма (Миллер—Рабин) по основанию 1 < base < m - 1; m нечётно
+bool miller_rabin(montgomery const &mt, u32 const *m, u32 base);
+// сильный тест Люка, P = 1, Q = (1 - D) / 4, D — первое из 5, -7, 9, -11, ...
+// с символом Якоби (D / m) = -1; m нечётно, больше TRIAL_DIVISION_LIMIT и не квадрат
+bool strong_lucas(montgomery const &mt, u32 const *m);
+
+#endif //BIGINT__LIMB_PRIME_H_
@@ -0,0 +1,86 @@
+#include "limb_scratch.h"
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+namespace {
+// выделения выравниваются на линию кэша: ядра читают операнды векторно
+const size_t ALIGN_LIMBS = 64 / sizeof(u32);
+
+struct chunk_memory {
+    std::vector<u32> mem;
+    u32 *base;
+    size_t size;
+
+    explicit chunk_memory(size_t n) : mem(n + ALIGN_LIMBS), size(n) {
+        uintptr_t p = reinterpret_cast<uintptr_t>(mem.data());
+        base = mem.data() + ((-p / sizeof(u32)) & (ALIGN_LIMBS - 1));
+    }
+};
+
+struct scratch_stack {
+    std::vector<chunk_memory> chunks;
+    // вершина: кусок и смещение в нём; куски после текущего свободны
+    size_t chunk = 0;
+    size_t top = 0;
+};
+
+thread_local scratch_stack stack;
+}
+
+struct scratch_mark::heap_block {
+    heap_block *next;
+
+    u32 *limbs() {
+        return reinterpret_cast<u32 *>(this + 1);
+    }
+};
+
+scratch_mark::scratch_mark() : chunk_(stack.chunk), top_(stack.top), heap_(nullptr) {}
+
+scratch_mark::~scratch_mark() {
+    stack.chunk = chunk_;
+    stack.top = top_;
+    while (heap_) {
+        heap_block *b = heap_;
+        heap_ = b->next;
+        operator delete(b);
+    }
+}
+
+u32 *scratch_mark::alloc(size_t n) {
+    if (n > SCRATCH_HEAP_LIMIT) {
+        heap_block *b = static_cast<heap_block *>(operator new(sizeof(heap_block) + n * sizeof(u32)));
+        b->next = heap_;
+        heap_ = b;
+        return b->limbs();
+    }
+    n = (n + ALIGN_LIMBS - 1) & ~(ALIGN_LIMBS - 1);
+    scratch_stack &s = stack;
+    if (s.chunks.empty() || s.top + n > s.chunks[s.chunk].size) {
+        // текущий кусок кончился: следующий, если он есть и в него влезает n,
+        // иначе новый вдвое больше последнего
+        size_t next = s.chunks.empty() ? 0 : s.chunk + 1;
+        size_t grow = s.chunks.empty() ? SCRATCH_CHUNK : std::min(2 * s.chunks.back().size, SCRATCH_HEAP_LIMIT);
+        size_t size = std::max(n, grow);
+        if (next == s.chunks.size()) {
+            s.chunks.emplace_back(size);
+        } else if (s.chunks[next].size < n) {
+            s.chunks[next] = chunk_memory(size);
+        }
+        s.chunk = next;
+        s.top = 0;
+    }
+    u32 *p = s.chunks[s.chunk].base + s.top;
+    s.top += n;
+    return p;
+}
+
+size_t scratch_capacity() {
+    size_t n = 0;
+    for (auto const &c : stack.chunks) {
+        n += c.size;
+    }
+    return n;
+}
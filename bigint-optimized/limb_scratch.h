@@ -0,0 +1,41 @@
+#ifndef BIGINT__LIMB_SCRATCH_H_
+#define BIGINT__LIMB_SCRATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#define u32 uint32_t
+
+// Стек временных лимбов на поток, как TMP_ALLOC в GMP: выделение — сдвиг
+// вершины, освобождение — возврат вершины к отметке в деструкторе
+// scratch_mark, так что временные массивы рекурсивных умножения и деления
+// освобождаются строго в обратном порядке. Память стека идёт кусками и
+// остаётся у потока; запросы больше SCRATCH_HEAP_LIMIT лимбов берутся из кучи.
+
+// первый кусок стека, лимбов
+const size_t SCRATCH_CHUNK = static_cast<size_t>(1) << 14;
+const size_t SCRATCH_HEAP_LIMIT = static_cast<size_t>(1) << 22;
+
+class scratch_mark {
+ public:
+     scratch_mark();
+     ~scratch_mark();
+     scratch_mark(scratch_mark const &) = delete;
+     scratch_mark &operator=(scratch_mark const &) = delete;
+
+     // n лимбов с произвольным содержимым, живут до разрушения отметки;
+     // отметка и все её выделения — в одном потоке
+     u32 *alloc(size_t n);
+
+ private:
+     struct heap_block;
+
+     size_t chunk_;
+     size_t top_;
+     heap_block *heap_;
+};
+
+// сколько лимбов держит стек текущего потока
+size_t scratch_capacity();
+
+#endif //BIGINT__LIMB_SCRATCH_H_
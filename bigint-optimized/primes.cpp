@@ -0,0 +1,22 @@
+#include "primes.h"
+
+std::vector<u32> primes_up_to(u32 n) {
+    std::vector<u32> primes;
+    if (n < 2) {
+        return primes;
+    }
+    primes.push_back(2);
+    // composite[i] — составное ли 2i + 1
+    std::vector<bool> composite(n / 2 + 1);
+    for (uint64_t i = 1; 2 * i + 1 <= n; i++) {
+        if (composite[i]) {
+            continue;
+        }
+        uint64_t p = 2 * i + 1;
+        primes.push_back(static_cast<u32>(p));
+        for (uint64_t j = p * p / 2; j <= n / 2; j += p) {
+            composite[j] = true;
+        }
+    }
+    return primes;
+}
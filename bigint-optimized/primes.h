@@ -0,0 +1,12 @@
+#ifndef BIGINT__PRIMES_H_
+#define BIGINT__PRIMES_H_
+
+#include <cstdint>
+#include <vector>
+
+#define u32 uint32_t
+
+// простые числа, не превосходящие n, по возрастанию; решето Эратосфена по нечётным
+std::vector<u32> primes_up_to(u32 n);
+
+#endif //BIGINT__PRIMES_H_
@@ -0,0 +1,295 @@
+#include "tagged_integer.h"
+
+#include <algorithm>
+#include <ostream>
+#include <utility>
+
+tagged_integer::tagged_integer() : word_(1) {}
+
+tagged_integer::tagged_integer(int64_t a) : word_(1) {
+    set(a);
+}
+
+tagged_integer::tagged_integer(big_integer const &a) : word_(1) {
+    set(a);
+}
+
+tagged_integer::tagged_integer(tagged_integer const &other) : word_(other.word_) {
+    if (limb_buffer *b = heap()) {
+        b->add();
+    }
+}
+
+tagged_integer::tagged_integer(tagged_integer &&other) noexcept : word_(other.word_) {
+    other.word_ = 1;
+}
+
+tagged_integer::~tagged_integer() {
+    if (limb_buffer *b = heap()) {
+        b->del();
+    }
+}
+
+tagged_integer &tagged_integer::operator=(tagged_integer const &other) {
+    // сначала захватываем чужой блок: при самоприсваивании del() не должен его удалить
+    if (limb_buffer *b = other.heap()) {
+        b->add();
+    }
+    limb_buffer *old = heap();
+    word_ = other.word_;
+    if (old) {
+        old->del();
+    }
+    return *this;
+}
+
+tagged_integer &tagged_integer::operator=(tagged_integer &&other) noexcept {
+    swap(other);
+    return *this;
+}
+
+void tagged_integer::swap(tagged_integer &other) noexcept {
+    std::swap(word_, other.word_);
+}
+
+void swap(tagged_integer &a, tagged_integer &b) noexcept {
+    a.swap(b);
+}
+
+bool tagged_integer::is_inline() const {
+    return word_ & 1;
+}
+
+int64_t tagged_integer::small() const {
+    return static_cast<int64_t>(word_) >> 1;
+}
+
+limb_buffer *tagged_integer::heap() const {
+    return is_inline() ? nullptr : reinterpret_cast<limb_buffer *>(word_ & ~NEGATIVE);
+}
+
+big_integer tagged_integer::value() const {
+    if (is_inline()) {
+        return big_integer(small());
+    }
+    big_integer r;
+    r.data_.data.big = heap()->add();
+    r.data_.is_small = 0;
+    r.data_.length = heap()->capacity;
+    r.data_.positive = !(word_ & NEGATIVE);
+    return r;
+}
+
+big_integer tagged_integer::take() {
+    big_integer r = value();
+    if (limb_buffer *b = heap()) {
+        b->del();
+        word_ = 1;
+    }
+    return r;
+}
+
+void tagged_integer::set(int64_t v) {
+    if (v <= -INLINE_LIMIT || v >= INLINE_LIMIT) {
+        set(big_integer(v));
+        return;
+    }
+    limb_buffer *old = heap();
+    word_ = static_cast<uintptr_t>(v) << 1 | 1;
+    if (old) {
+        old->del();
+    }
+}
+
+void tagged_integer::set(big_integer const &v) {
+    if (v.bit_length() < 63) {
+        set(to_int64(v));
+        return;
+    }
+    // v может лежать в старом блоке: он отпускается последним
+    container const &c = v.data_;
+    limb_buffer *b;
+    if (!c.is_small && c.data.big->capacity == c.length) {
+        b = c.data.big->add();
+    } else {
+        b = limb_buffer::create(c.length);
+        std::copy(c.span(), c.span() + c.length, b->limbs());
+        b->trim_capacity(c.length);
+    }
+    limb_buffer *old = heap();
+    word_ = reinterpret_cast<uintptr_t>(b) | (c.positive ? 0 : NEGATIVE);
+    if (old) {
+        old->del();
+    }
+}
+
+void tagged_integer::set(big_integer &&v) {
+    // единоличный блок временного v подрезается до длины и забирается без копии
+    container &c = v.data_;
+    if (!c.is_small && c.unique()) {
+        c.data.big->trim_capacity(c.length);
+    }
+    set(static_cast<big_integer const &>(v));
+}
+
+// перенос сразу помещается в блок, так что сумма остаётся в его классе пула
+// и set забирает её без копирования
+void tagged_integer::add(tagged_integer const &rhs, bool subtract) {
+    big_integer r = rhs.value();
+    big_integer l = take();
+    l.reserve(std::max(l.data_.size(), r.data_.size()) + 1);
+    if (subtract) {
+        l -= r;
+    } else {
+        l += r;
+    }
+    set(std::move(l));
+}
+
+big_integer tagged_integer::to_big_integer() const {
+    return value();
+}
+
+// сумма и разность двух чисел меньше 2^62 по модулю в int64_t не переполняются
+tagged_integer &tagged_integer::operator+=(tagged_integer const &rhs) {
+    if (is_inline() && rhs.is_inline()) {
+        set(small() + rhs.small());
+    } else {
+        add(rhs, false);
+    }
+    return *this;
+}
+
+tagged_integer &tagged_integer::operator-=(tagged_integer const &rhs) {
+    if (is_inline() && rhs.is_inline()) {
+        set(small() - rhs.small());
+    } else {
+        add(rhs, true);
+    }
+    return *this;
+}
+
+tagged_integer &tagged_integer::operator*=(tagged_integer const &rhs) {
+    int64_t r;
+    if (is_inline() && rhs.is_inline() && !__builtin_mul_overflow(small(), rhs.small(), &r)) {
+        set(r);
+    } else {
+        set(value() * rhs.value());
+    }
+    return *this;
+}
+
+// частное и остаток по модулю не больше делимого; деление на ноль — как у big_integer
+tagged_integer &tagged_integer::operator/=(tagged_integer const &rhs) {
+    if (is_inline() && rhs.is_inline() && rhs.small() != 0) {
+        set(small() / rhs.small());
+    } else {
+        set(value() / rhs.value());
+    }
+    return *this;
+}
+
+tagged_integer &tagged_integer::operator%=(tagged_integer const &rhs) {
+    if (is_inline() && rhs.is_inline() && rhs.small() != 0) {
+        set(small() % rhs.small());
+    } else {
+        set(value() % rhs.value());
+    }
+    return *this;
+}
+
+tagged_integer tagged_integer::operator+() const {
+    return *this;
+}
+
+// число вне слова не ноль: минус — тот же блок с другим битом знака
+tagged_integer tagged_integer::operator-() const {
+    if (is_inline()) {
+        return tagged_integer(-small());
+    }
+    tagged_integer r(*this);
+    r.word_ ^= NEGATIVE;
+    return r;
+}
+
+tagged_integer operator+(tagged_integer a, tagged_integer const &b) {
+    a += b;
+    return a;
+}
+
+tagged_integer operator-(tagged_integer a, tagged_integer const &b) {
+    a -= b;
+    return a;
+}
+
+tagged_integer operator*(tagged_integer a, tagged_integer const &b) {
+    a *= b;
+    return a;
+}
+
+tagged_integer operator/(tagged_integer a, tagged_integer const &b) {
+    a /= b;
+    return a;
+}
+
+tagged_integer operator%(tagged_integer a, tagged_integer const &b) {
+    a %= b;
+    return a;
+}
+
+// представление однозначно: число в слове никогда не равно числу в блоке,
+// а длина числа в блоке — его вместимость
+bool operator==(tagged_integer const &a, tagged_integer const &b) {
+    if (a.word_ == b.word_) {
+        return true;
+    }
+    if (a.is_inline() || b.is_inline() || (a.word_ ^ b.word_) & tagged_integer::NEGATIVE) {
+        return false;
+    }
+    limb_buffer const *x = a.heap();
+    limb_buffer const *y = b.heap();
+    return x->capacity == y->capacity && std::equal(x->limbs(), x->limbs() + x->capacity, y->limbs());
+}
+
+bool operator!=(tagged_integer const &a, tagged_integer const &b) {
+    return !(a == b);
+}
+
+// число в блоке по модулю больше любого числа в слове, так что при смешанных
+// операндах всё решает знак того, что в блоке
+bool operator<(tagged_integer const &a, tagged_integer const &b) {
+    if (a.is_inline() && b.is_inline()) {
+        return a.small() < b.small();
+    }
+    if (a.is_inline()) {
+        return !(b.word_ & tagged_integer::NEGATIVE);
+    }
+    if (b.is_inline()) {
+        return a.word_ & tagged_integer::NEGATIVE;
+    }
+    return a.value() < b.value();
+}
+
+bool operator>(tagged_integer const &a, tagged_integer const &b) {
+    return b < a;
+}
+
+bool operator<=(tagged_integer const &a, tagged_integer const &b) {
+    return !(b < a);
+}
+
+bool operator>=(tagged_integer const &a, tagged_integer const &b) {
+    return !(a < b);
+}
+
+std::string to_string(tagged_integer const &a) {
+    return a.is_inline() ? std::to_string(a.small()) : to_string(a.value());
+}
+
+std::ostream &operator<<(std::ostream &s, tagged_integer const &a) {
+    return s << to_string(a);
+}
+
+size_t std::hash<tagged_integer>::operator()(tagged_integer const &a) const {
+    return a.is_inline() ? std::hash<int64_t>()(a.small()) : std::hash<big_integer>()(a.value());
+}
@@ -0,0 +1,100 @@
+#ifndef BIGINT__TAGGED_INTEGER_H_
+#define BIGINT__TAGGED_INTEGER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include "big_integer.h"
+
+// Целое в одном машинном слове — для таблиц, где почти все значения мелкие.
+// Если младший бит слова установлен, в остальных 63 битах лежит само число
+// со знаком; иначе слово — указатель на limb_buffer, тот же общий блок лимбов
+// со счётчиком ссылок, что у big_integer, а бит 1 — знак. Вместимость такого
+// блока равна длине числа, так что big_integer над ним собирается без
+// копирования, а его результат забирается в слово. Числа с |x| < 2^62 всегда хранятся в слове,
+// так что представление однозначно: сравнение и хеш двух маленьких значений
+// в кучу не ходят, а в big_integer арифметика уходит только при переполнении.
+class tagged_integer {
+ public:
+     tagged_integer();
+     tagged_integer(int64_t a);
+     tagged_integer(big_integer const &a);
+     tagged_integer(tagged_integer const &other);
+     // other становится нулём
+     tagged_integer(tagged_integer &&other) noexcept;
+     ~tagged_integer();
+
+     tagged_integer &operator=(tagged_integer const &other);
+     tagged_integer &operator=(tagged_integer &&other) noexcept;
+     void swap(tagged_integer &other) noexcept;
+
+     // true, если число лежит в самом слове
+     bool is_inline() const;
+     big_integer to_big_integer() const;
+
+     tagged_integer &operator+=(tagged_integer const &rhs);
+     tagged_integer &operator-=(tagged_integer const &rhs);
+     tagged_integer &operator*=(tagged_integer const &rhs);
+     tagged_integer &operator/=(tagged_integer const &rhs);
+     tagged_integer &operator%=(tagged_integer const &rhs);
+
+     tagged_integer operator+() const;
+     tagged_integer operator-() const;
+
+     friend bool operator==(tagged_integer const &a, tagged_integer const &b);
+     friend bool operator<(tagged_integer const &a, tagged_integer const &b);
+     friend std::string to_string(tagged_integer const &a);
+     friend struct std::hash<tagged_integer>;
+
+ private:
+     // в слове хранятся числа строго между -INLINE_LIMIT и INLINE_LIMIT
+     static const int64_t INLINE_LIMIT = static_cast<int64_t>(1) << 62;
+
+     // бит знака в слове-указателе; блоки пула выровнены минимум на 16
+     static const uintptr_t NEGATIVE = 2;
+
+     int64_t small() const;
+     limb_buffer *heap() const;
+     // big_integer над тем же блоком, без копирования лимбов
+     big_integer value() const;
+     // то же, но блок переходит в big_integer, а само число становится нулём
+     big_integer take();
+     // заменяет значение, отпуская прежний блок; блок v берётся как есть,
+     // если его вместимость равна длине или, для временного v, может ей стать
+     void set(int64_t v);
+     void set(big_integer const &v);
+     void set(big_integer &&v);
+     // *this += rhs или *this -= rhs вне слова
+     void add(tagged_integer const &rhs, bool subtract);
+
+     uintptr_t word_;
+};
+
+void swap(tagged_integer &a, tagged_integer &b) noexcept;
+
+tagged_integer operator+(tagged_integer a, tagged_integer const &b);
+tagged_integer operator-(tagged_integer a, tagged_integer const &b);
+tagged_integer operator*(tagged_integer a, tagged_integer const &b);
+tagged_integer operator/(tagged_integer a, tagged_integer const &b);
+tagged_integer operator%(tagged_integer a, tagged_integer const &b);
+
+bool operator==(tagged_integer const &a, tagged_integer const &b);
+bool operator!=(tagged_integer const &a, tagged_integer const &b);
+bool operator<(tagged_integer const &a, tagged_integer const &b);
+bool operator>(tagged_integer const &a, tagged_integer const &b);
+bool operator<=(tagged_integer const &a, tagged_integer const &b);
+bool operator>=(tagged_integer const &a, tagged_integer const &b);
+
+std::string to_string(tagged_integer const &a);
+std::ostream &operator<<(std::ostream &s, tagged_integer const &a);
+
+namespace std {
+template<>
+struct hash<tagged_integer> {
+    size_t operator()(tagged_integer const &a) const;
+};
+}
+
+#endif //BIGINT__TAGGED_INTEGER_H_
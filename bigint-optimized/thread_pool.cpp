@@ -0,0 +1,98 @@
+#include "thread_pool.h"
+
+thread_pool::thread_pool(size_t workers) : stop_(false) {
+    for (size_t i = 0; i < workers; i++) {
+        threads_.emplace_back(&thread_pool::work, this);
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : threads_) {
+        t.join();
+    }
+}
+
+size_t thread_pool::workers() const {
+    return threads_.size();
+}
+
+void thread_pool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+bool thread_pool::run_pending() {
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+            return false;
+        }
+        task = std::move(queue_.front());
+        queue_.pop_front();
+    }
+    task();
+    return true;
+}
+
+void thread_pool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        task();
+    }
+}
+
+task_group::task_group(thread_pool &pool) : pool_(pool), pending_(0) {}
+
+task_group::~task_group() {
+    while (pending_.load(std::memory_order_acquire) != 0) {
+        if (!pool_.run_pending()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void task_group::run(std::function<void()> task) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_.submit([this, task] {
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+        pending_.fetch_sub(1, std::memory_order_release);
+    });
+}
+
+void task_group::wait() {
+    while (pending_.load(std::memory_order_acquire) != 0) {
+        if (!pool_.run_pending()) {
+            std::this_thread::yield();
+        }
+    }
+    if (error_) {
+        std::exception_ptr e = error_;
+        error_ = nullptr;
+        std::rethrow_exception(e);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef BIGINT__THREAD_POOL_H_
+#define BIGINT__THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул рабочих потоков. Поток, ждущий свои задачи, сам выполняет задачи из
+// очереди, поэтому вложенные task_group не блокируют пул.
+class thread_pool {
+ public:
+     explicit thread_pool(size_t workers);
+     ~thread_pool();
+     thread_pool(thread_pool const &) = delete;
+     thread_pool &operator=(thread_pool const &) = delete;
+
+     size_t workers() const;
+     void submit(std::function<void()> task);
+     // выполняет одну задачу из очереди; false, если очередь пуста
+     bool run_pending();
+
+ private:
+     void work();
+
+     std::vector<std::thread> threads_;
+     std::deque<std::function<void()>> queue_;
+     std::mutex mutex_;
+     std::condition_variable cv_;
+     bool stop_;
+};
+
+class task_group {
+ public:
+     explicit task_group(thread_pool &pool);
+     ~task_group();
+     task_group(task_group const &) = delete;
+     task_group &operator=(task_group const &) = delete;
+
+     void run(std::function<void()> task);
+     // дожидается всех задач группы и пробрасывает первое исключение
+     void wait();
+
+ private:
+     thread_pool &pool_;
+     std::atomic<size_t> pending_;
+     std::mutex error_mutex_;
+     std::exception_ptr error_;
+};
+
+#endif //BIGINT__THREAD_POOL_H_
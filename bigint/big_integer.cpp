@@ -5,6 +5,7 @@
 #include <iostream>
 #include <string>
 #include <algorithm>
+#include <limits>
 #define u32 uint32_t
 
 big_integer::big_integer() : positive(true) {
@@ -153,7 +154,7 @@ big_integer &big_integer::operator^=(big_integer const &rhs) {
 big_integer &big_integer::operator<<=(int rhs) {
     int in = rhs % BASE;
     int out = rhs / BASE;
-    vector<u32> res(data_.size() + out + 1);
+    cont res(data_.size() + out + 1);
     for (size_t i = data_.size(); i != 0; i--) {
         auto p = split64(static_cast<uint64_t>(data_[i - 1]) << in);
         res[i + out - 1] |= p.first;
@@ -168,7 +169,7 @@ big_integer &big_integer::operator>>=(int rhs) {
     int in = rhs % BASE;
     int out = rhs / BASE;
     auto d = additionTo2(data_);
-    vector<u32> res(d.size());
+    cont res(d.size());
     for (int i = 0; i != (int) d.size(); i++) {
         auto p = split64(static_cast<uint64_t>(d[i]) << (BASE - in));
         if (i - out >= 0)
@@ -334,8 +335,8 @@ pair<uint32_t, uint32_t> big_integer::split64(uint64_t n) {
 
 void big_integer::subABS(big_integer const &b) {
     bool loan = false;
-    vector<u32> t1;
-    vector<u32> t2;
+    cont t1;
+    cont t2;
     if ((*this < b) ^ !positive) {
         t1 = b.data_;
         t2 = (*this).data_;
@@ -370,11 +371,11 @@ void big_integer::sumABS(big_integer const &b) {
     if (over)
         data_.push_back(over);
 }
-void big_integer::toFit(vector<uint32_t> &v) {
+void big_integer::toFit(cont &v) {
     while (v.size() != 1 && v[v.size() - 1] == 0)
         v.pop_back();
 }
-vector<uint32_t> big_integer::additionTo2(vector<uint32_t> const &v, bool is2) const {
+big_integer::cont big_integer::additionTo2(cont const &v, bool is2) const {
     big_integer temp;
     temp.data_ = v;
     bool high = highBit(temp.data_);
@@ -389,7 +390,7 @@ vector<uint32_t> big_integer::additionTo2(vector<uint32_t> const &v, bool is2) c
     temp++;
     return temp.data_;
 }
-bool big_integer::highBit(vector<uint32_t> &v) {
+bool big_integer::highBit(cont &v) {
     return (v.back() & (static_cast<u32>(1) << (BASE - 1)));
 }
 pair<big_integer, big_integer> big_integer::div(big_integer &v, big_integer const &d) {
@@ -417,7 +418,7 @@ pair<big_integer, big_integer> big_integer::divM_N(big_integer &v, big_integer c
     v <<= i;
     d <<= i;
     int k = v.data_.size() - d.data_.size();
-    vector<u32> res;
+    cont res;
     big_integer dk = d << (int) (BASE * k);
     if (v >= dk) {
         res.push_back(1);
@@ -5,11 +5,14 @@
 #include <iosfwd>
 #include <vector>
 #include <cstdint>
+#include "limb_pool.h"
 
 using namespace std;
 
 struct big_integer {
      typedef unsigned __int128 uint128_t;
+     // лимбы в памяти из limb_pool
+     typedef vector<uint32_t, pool_allocator<uint32_t>> cont;
      big_integer();
      big_integer(big_integer const &other);
      big_integer(int a);
@@ -51,7 +54,7 @@ struct big_integer {
      friend std::string to_string(big_integer const &a);
 
  private:
-     vector<uint32_t> data_;
+     cont data_;
      bool positive;
      static const uint32_t BASE = 32;
      static const uint32_t MAX_DIGIT = (((uint64_t) 1) << BASE) - 1;
@@ -60,9 +63,9 @@ struct big_integer {
      uint32_t get(int i);
      void sumABS(big_integer const &b);
      void subABS(big_integer const &b);
-     static void toFit(vector<uint32_t> &v);
-     vector<uint32_t> additionTo2(vector<uint32_t> const &v, bool is2 = false) const;
-     static bool highBit(vector<uint32_t> &v);
+     static void toFit(cont &v);
+     cont additionTo2(cont const &v, bool is2 = false) const;
+     static bool highBit(cont &v);
      static pair<big_integer, big_integer> div(big_integer &v, big_integer const &d);
      static pair<big_integer, big_integer> divM_N(big_integer &v, big_integer const &d);
      static pair<big_integer, big_integer> div_primal(big_integer &v, big_integer const &d);
@@ -809,6 +809,34 @@ TEST(correctness_random, bit_shifts) {
   }
 }
 
+TEST(correctness, limb_pool) {
+  pool_trim();
+  EXPECT_EQ(0u, pool_statistics().retained);
+  {
+    big_integer x = big_integer(1) << 1000;
+  }
+  // the limbs of x went to this thread's lists, not back to the heap
+  size_t retained = pool_statistics().retained;
+  EXPECT_LT(0u, retained);
+  EXPECT_EQ(retained, pool_retained());
+  uint64_t hits = pool_statistics().hits;
+  for (int i = 0; i < 10; i++) {
+    big_integer x = big_integer(1) << 1000;
+    EXPECT_EQ(big_integer(3) << 1000, x * 3);
+  }
+  EXPECT_LT(hits, pool_statistics().hits);
+
+  size_t limit = pool_limit();
+  set_pool_limit(0);
+  pool_trim();
+  {
+    big_integer x = big_integer(1) << 1000;
+  }
+  EXPECT_EQ(0u, pool_statistics().retained);
+  EXPECT_EQ(0u, pool_retained());
+  set_pool_limit(limit);
+}
+
 // TODO: extend due to idea
 TEST(correctness_twos_complement, simple) {
   std::string a = "-36893488147419103232"; // -(1 << 65)